@@ -56,6 +56,133 @@ void for_each(Container const& container, F&& f)
     for_each(begin(container), end(container), std::forward<F>(f));
 }
 
+template <typename Iter, typename Tp, typename Op>
+Tp reduce(Iter first, Iter last, Tp init, Op&& op)
+{
+    for (; first != last; ++first)
+        init = op(init, *first);
+    return init;
+}
+
+template <typename Container, typename Tp, typename Op>
+Tp reduce(Container const& container, Tp init, Op&& op)
+{
+    return reduce(begin(container), end(container), init, std::forward<Op>(op));
+}
+
+template <typename Iter, typename Tp, typename ReduceOp, typename TransformOp>
+Tp transform_reduce(Iter first, Iter last, Tp init, ReduceOp&& reduce_op, TransformOp&& transform_op)
+{
+    for (; first != last; ++first)
+        init = reduce_op(init, transform_op(*first));
+    return init;
+}
+
+template <typename Container, typename Tp, typename ReduceOp, typename TransformOp>
+Tp transform_reduce(Container const& container, Tp init, ReduceOp&& reduce_op, TransformOp&& transform_op)
+{
+    return transform_reduce(begin(container), end(container), init, std::forward<ReduceOp>(reduce_op), std::forward<TransformOp>(transform_op));
+}
+
+template <typename Iter, typename F>
+size_t count_if(Iter first, Iter last, F&& f)
+{
+    size_t count = 0;
+    for (; first != last; ++first)
+    {
+        if (f(*first))
+            count++;
+    }
+    return count;
+}
+
+template <typename Container, typename F>
+size_t count_if(Container const& container, F&& f)
+{
+    return count_if(begin(container), end(container), std::forward<F>(f));
+}
+
+// the first smallest element, last if the range is empty
+template <typename Iter, typename Pred = Less<typename Iter::value_type>>
+Iter min_element(Iter first, Iter last, Pred predicate = Pred())
+{
+    Iter ret = first;
+    for (; first != last; ++first)
+    {
+        if (predicate(*first, *ret))
+            ret = first;
+    }
+    return ret;
+}
+
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+typename Container::Iterator min_element(Container& container, Pred predicate = Pred())
+{
+    return min_element(begin(container), end(container), predicate);
+}
+
+// the first largest element, last if the range is empty
+template <typename Iter, typename Pred = Less<typename Iter::value_type>>
+Iter max_element(Iter first, Iter last, Pred predicate = Pred())
+{
+    Iter ret = first;
+    for (; first != last; ++first)
+    {
+        if (predicate(*ret, *first))
+            ret = first;
+    }
+    return ret;
+}
+
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+typename Container::Iterator max_element(Container& container, Pred predicate = Pred())
+{
+    return max_element(begin(container), end(container), predicate);
+}
+
+// output[i] = input[0] op ... op input[i], output may be the input itself
+template <typename Iter, typename OutIter, typename Op>
+OutIter inclusive_scan(Iter first, Iter last, OutIter output, Op&& op)
+{
+    if (first == last)
+        return output;
+
+    auto sum = *first;
+    *output = sum;
+    for (++first, ++output; first != last; ++first, ++output)
+    {
+        sum = op(sum, *first);
+        *output = sum;
+    }
+    return output;
+}
+
+// output must have at least as many elements as input
+template <typename Container, typename OutContainer, typename Op>
+void inclusive_scan(Container const& input, OutContainer& output, Op&& op)
+{
+    inclusive_scan(begin(input), end(input), begin(output), std::forward<Op>(op));
+}
+
+// output[i] = init op input[0] op ... op input[i - 1], output may be the input itself
+template <typename Iter, typename OutIter, typename Tp, typename Op>
+OutIter exclusive_scan(Iter first, Iter last, OutIter output, Tp init, Op&& op)
+{
+    for (; first != last; ++first, ++output)
+    {
+        Tp next = op(init, *first);
+        *output = init;
+        init = next;
+    }
+    return output;
+}
+
+template <typename Container, typename OutContainer, typename Tp, typename Op>
+void exclusive_scan(Container const& input, OutContainer& output, Tp init, Op&& op)
+{
+    exclusive_scan(begin(input), end(input), begin(output), init, std::forward<Op>(op));
+}
+
 AMAZING_NAMESPACE_END
 
 #endif //ITER_H
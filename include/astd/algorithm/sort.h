@@ -70,29 +70,33 @@ Iter median_of_three(Iter first, Iter last, Pred pred)
 template <typename Iter, typename Pred>
 void sort_unchecked(Iter first, Iter last, Pred pred)
 {
-    Iter prev_last = iter_move(last, -1);
-    if (first == prev_last || first == last)
+    if (last - first < 2)
         return;
 
     Iter mid = median_of_three(first, last, pred);
     Amazing::swap(*first, *mid);
 
+    // elements equal to the pivot stop both scans, so runs of equal elements are split in halves
     Iter begin = first;
-    Iter end = prev_last;
-    while (begin != end)
+    Iter end = last;
+    while (true)
     {
-        while (!pred(*end, *begin) && begin != end)
-            --end;
+        do
+            ++begin;
+        while (begin != last && pred(*begin, *first));
 
-        Amazing::swap(*begin, *end);
+        do
+            --end;
+        while (pred(*first, *end));
 
-        while (!pred(*end, *begin) && begin != end)
-            ++begin;
+        if (end - begin <= 0)
+            break;
 
         Amazing::swap(*begin, *end);
     }
+    Amazing::swap(*first, *end);
 
-    sort_unchecked(first, begin, pred);
+    sort_unchecked(first, end, pred);
     sort_unchecked(++end, last, pred);
 }
 
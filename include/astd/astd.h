@@ -17,11 +17,14 @@
 #include "container/ring.h"
 
 #include "memory/pointer.h"
+#include "memory/arena.h"
+#include "memory/pool.h"
 
 #include "algorithm/sort.h"
 #include "algorithm/iter.h"
 
 #include "sync/parallel.h"
+#include "sync/task/coroutine.h"
 
 AMAZING_NAMESPACE_BEGIN
 
@@ -10,6 +10,14 @@
 #define INTERNAL_NAMESPACE_END  NAMESPACE_END(Internal)
 
 #define NODISCARD [[nodiscard]]
+#define MAYBE_UNUSED [[maybe_unused]]
+
+// empty members, such as stateless allocators, take no space
+#ifdef _MSC_VER
+#define NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
 
 #ifdef __GNUC__
 #include <bits/functional_hash.h>
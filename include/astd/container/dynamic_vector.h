@@ -75,21 +75,22 @@ public:
     };
 public:
     DynamicVector() : m_data(nullptr), m_bucket(0), m_size(0), m_capacity(0) {}
+    explicit DynamicVector(const allocator& alloc) : m_data(nullptr), m_bucket(0), m_size(0), m_capacity(0), m_allocator(alloc) {}
     ~DynamicVector()
     {
         for (size_t i = 0; i < m_bucket; ++i)
-            allocator::deallocate(m_data[i]);
-        Alloc<Tp*>::deallocate(m_data);
+            m_allocator.deallocate(m_data[i]);
+        Alloc<Tp*>(m_allocator).deallocate(m_data);
     }
 
-    explicit DynamicVector(size_t size) : m_size(size)
+    explicit DynamicVector(size_t size, const allocator& alloc = allocator()) : m_size(size), m_allocator(alloc)
     {
         m_bucket = division_up(size, Block_Size);
         m_capacity = m_bucket * Block_Size;
 
-        m_data = Alloc<Tp*>::allocate(m_bucket);
+        m_data = Alloc<Tp*>(m_allocator).allocate(m_bucket);
         for (size_t i = 0; i < m_bucket; ++i)
-            m_data[i] = allocator::allocate(Block_Size);
+            m_data[i] = m_allocator.allocate(Block_Size);
     }
 
     void resize(size_t size)
@@ -105,23 +106,20 @@ public:
         if (bucket == m_bucket)
             return;
 
-        Tp** new_data = Alloc<Tp*>::reallocate(m_data, bucket);
+        // dropped buckets are released first, shrinking the table in place clears its tail
+        for (size_t i = bucket; i < m_bucket; ++i)
+            m_allocator.deallocate(m_data[i]);
+
+        Tp** new_data = Alloc<Tp*>(m_allocator).reallocate(m_data, bucket);
         if (new_data != m_data)
         {
             std::memcpy(new_data, m_data, sizeof(Tp*) * std::min(bucket, m_bucket));
-            for (size_t i = bucket; i < m_bucket; ++i)
-                allocator::deallocate(m_data[i]);
-            Alloc<Tp*>::deallocate(m_data);
+            Alloc<Tp*>(m_allocator).deallocate(m_data);
             m_data = new_data;
         }
-        else
-        {
-            for (size_t i = bucket; i < m_bucket; ++i)
-                allocator::deallocate(m_data[i]);
-        }
 
         for (size_t i = m_bucket; i < bucket; ++i)
-            m_data[i] = allocator::allocate(Block_Size);
+            m_data[i] = m_allocator.allocate(Block_Size);
 
         m_bucket = bucket;
         m_capacity = bucket * Block_Size;
@@ -177,6 +175,7 @@ private:
     size_t m_bucket;
     size_t m_size;
     size_t m_capacity;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
@@ -128,11 +128,13 @@ public:
         friend class Hash;
     };
 public:
-    Hash() : m_size(0)
+    Hash() : Hash(allocator()) {}
+
+    explicit Hash(const allocator& alloc) : m_size(0), m_allocator(alloc)
     {
         m_bucket_count = Bucket_Count;
         size_t element_size = m_bucket_count * max_bucket_size + 1;
-        m_buckets = allocator::allocate(element_size * sizeof(node_type));
+        m_buckets = m_allocator.allocate(element_size * sizeof(node_type));
         for (size_t i = 0; i < element_size; i++)
             new (m_buckets + i) node_type();
 
@@ -140,10 +142,10 @@ public:
         m_buckets[element_size - 1].flag = ElementFlag::e_end;
     }
 
-    Hash(const Hash& other) : m_bucket_count(other.m_bucket_count), m_size(other.m_size), m_probe(other.m_probe)
+    Hash(const Hash& other) : m_bucket_count(other.m_bucket_count), m_size(other.m_size), m_probe(other.m_probe), m_allocator(other.m_allocator)
     {
         size_t element_size = m_bucket_count * max_bucket_size + 1;
-        m_buckets = allocator::allocate(element_size * sizeof(node_type));
+        m_buckets = m_allocator.allocate(element_size * sizeof(node_type));
         for (size_t i = 0; i < element_size; i++)
             new (m_buckets + i) node_type();
 
@@ -154,16 +156,14 @@ public:
         m_buckets[element_size - 1].flag = ElementFlag::e_end;
     }
 
-    Hash(Hash&& other) noexcept : m_bucket_count(other.m_bucket_count), m_size(other.m_size)
+    Hash(Hash&& other) noexcept : m_buckets(nullptr), m_bucket_count(0), m_size(0), m_allocator(other.m_allocator)
     {
         swap(other);
     }
 
     ~Hash()
     {
-        for (size_t i = 0; i < m_bucket_count * max_bucket_size + 1; i++)
-            m_buckets[i].~node_type();
-        deallocate(m_buckets);
+        release_buckets();
         m_bucket_count = 0;
         m_size = 0;
     }
@@ -172,15 +172,13 @@ public:
     {
         if (this != &other)
         {
-            for (size_t i = 0; i < m_bucket_count * max_bucket_size + 1; i++)
-                m_buckets[i].~node_type();
-            deallocate(m_buckets);
+            release_buckets();
 
             m_bucket_count = other.m_bucket_count;
             m_size = other.m_size;
             m_probe = other.m_probe;
             size_t element_size = m_bucket_count * max_bucket_size + 1;
-            m_buckets = allocator::allocate(element_size * sizeof(node_type));
+            m_buckets = m_allocator.allocate(element_size * sizeof(node_type));
             for (size_t i = 0; i < element_size; i++)
                 new (m_buckets + i) node_type();
 
@@ -305,7 +303,7 @@ public:
         {
             size_t rehash_bucket_count = std::max(m_bucket_count * 2, new_bucket_count);
             size_t rehash_capacity = rehash_bucket_count * max_bucket_size + 1;
-            node_type* new_buckets = allocator::allocate(rehash_capacity * sizeof(node_type));
+            node_type* new_buckets = m_allocator.allocate(rehash_capacity * sizeof(node_type));
 
             m_probe.increment();
             for (size_t i = 0; i < capacity; i++)
@@ -326,7 +324,7 @@ public:
                         CONTAINER_LOG_ERROR("no suitable position to rehash!");
                 }
             }
-            allocator::deallocate(m_buckets);
+            m_allocator.deallocate(m_buckets);
             m_buckets = new_buckets;
             m_bucket_count = new_bucket_count;
         }
@@ -334,7 +332,7 @@ public:
         {
             size_t rehash_bucket_count = new_bucket_count;
             size_t rehash_capacity = rehash_bucket_count * max_bucket_size + 1;
-            node_type* new_buckets = allocator::allocate(rehash_capacity * sizeof(node_type));
+            node_type* new_buckets = m_allocator.allocate(rehash_capacity * sizeof(node_type));
 
             m_probe.decrement();
             for (size_t i = 0; i < capacity; i++)
@@ -355,7 +353,7 @@ public:
                         CONTAINER_LOG_ERROR("no suitable position to rehash!");
                 }
             }
-            allocator::deallocate(m_buckets);
+            m_allocator.deallocate(m_buckets);
             m_buckets = new_buckets;
             m_bucket_count = new_bucket_count;
         }
@@ -403,6 +401,12 @@ public:
         Amazing::swap(m_bucket_count, other.m_bucket_count);
         Amazing::swap(m_probe, other.m_probe);
         Amazing::swap(m_size, other.m_size);
+        Amazing::swap(m_allocator, other.m_allocator);
+    }
+
+    NODISCARD allocator get_allocator() const
+    {
+        return m_allocator;
     }
 
 protected:
@@ -419,11 +423,24 @@ protected:
         return m_buckets + m_bucket_count * max_bucket_size;
     }
 
+private:
+    // nodes are destroyed here, release memory through the same allocator without destroying them again
+    void release_buckets()
+    {
+        if (m_buckets == nullptr)
+            return;
+
+        for (size_t i = 0; i < m_bucket_count * max_bucket_size + 1; i++)
+            m_buckets[i].~node_type();
+        typename Trait::template alloc<uint8_t>(m_allocator).deallocate(reinterpret_cast<uint8_t*>(m_buckets));
+        m_buckets = nullptr;
+    }
 private:
     node_type* m_buckets;
     size_t m_bucket_count;
     size_t m_size;
     Probe m_probe;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
@@ -107,6 +107,7 @@ public:
     };
 public:
     BinaryTree() : m_root(nullptr), m_size(0) {}
+    explicit BinaryTree(const allocator& alloc) : m_root(nullptr), m_size(0), m_allocator(alloc) {}
 
     virtual ~BinaryTree()
     {
@@ -228,6 +229,11 @@ public:
         return m_size == 0;
     }
 
+    NODISCARD allocator get_allocator() const
+    {
+        return m_allocator;
+    }
+
     NODISCARD size_t count(const key_type& key) const
     {
         if (node_type* node = find_node(key))
@@ -432,11 +438,12 @@ protected:
 
     void erase_directly(node_type* node)
     {
-        allocator::deallocate(node);
+        m_allocator.deallocate(node);
     }
 protected:
     node_type* m_root;
     size_t      m_size;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
@@ -469,6 +476,7 @@ class RBTree : public BinaryTree<TreeTrait<Trait, RBTreeNode<typename Trait::val
 
     static constexpr bool is_set = std::is_same_v<key_type, value_type>;
 public:
+    using Tree::Tree;
     RBTree() = default;
     ~RBTree() override = default;
 private:
@@ -733,7 +741,7 @@ private:
 
     node_type* allocate_node(value_type&& val, node_type* parent) override
     {
-        node_type* node = allocator::allocate(1);
+        node_type* node = Tree::m_allocator.allocate(1);
         node->val = val;
         node->parent = parent;
         node->left = nullptr;
@@ -767,6 +775,7 @@ class AVLTree : public BinaryTree<TreeTrait<Trait, AVLTreeNode<typename Trait::v
     using typename Tree::node_type;
     using typename Tree::allocator;
 public:
+    using Tree::Tree;
     AVLTree() = default;
     ~AVLTree() override = default;
 private:
@@ -1015,7 +1024,7 @@ private:
 
     node_type* allocate_node(value_type&& val, node_type* parent) override
     {
-        node_type* node = allocator::allocate(1);
+        node_type* node = Tree::m_allocator.allocate(1);
         node->val = val;
         node->parent = parent;
         node->left = nullptr;
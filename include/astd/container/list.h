@@ -70,9 +70,11 @@ public:
         Internal::ListNode<Tp>* m_ptr;
     };
 public:
-    List() : m_size(0)
+    List() : List(allocator()) {}
+
+    explicit List(const allocator& alloc) : m_size(0), m_allocator(alloc)
     {
-        m_head = allocator::allocate(1);
+        m_head = m_allocator.allocate(1);
         m_head->val = Tp();
         m_head->prev = nullptr;
         m_head->next = nullptr;
@@ -82,13 +84,13 @@ public:
     {
         clear();
 
-        allocator::deallocate(m_head);
+        m_allocator.deallocate(m_head);
         m_head = nullptr;
     }
 
     void insert(size_t index, const Tp& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
 
         Internal::ListNode<Tp>* p = m_head;
@@ -127,7 +129,7 @@ public:
 
     void emplace_back(Tp&& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
         node->next = nullptr;
 
@@ -148,7 +150,7 @@ public:
 
     void push_back(const Tp& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
         node->next = nullptr;
 
@@ -169,7 +171,7 @@ public:
 
     void emplace_front(Tp&& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
         node->prev = m_head;
 
@@ -190,7 +192,7 @@ public:
 
     void push_front(const Tp& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
         node->prev = m_head;
 
@@ -224,7 +226,7 @@ public:
             m_head->next = nullptr;
         }
 
-        allocator::deallocate(node);
+        m_allocator.deallocate(node);
         node = nullptr;
 
         m_size--;
@@ -245,7 +247,7 @@ public:
             m_head->next = nullptr;
         }
 
-        allocator::deallocate(node);
+        m_allocator.deallocate(node);
         node = nullptr;
 
         m_size--;
@@ -278,7 +280,7 @@ public:
         {
             Internal::ListNode<Tp>* next = node->next;
 
-            allocator::deallocate(node);
+            m_allocator.deallocate(node);
             node = next;
         }
         m_head->next = nullptr;
@@ -300,6 +302,7 @@ public:
 private:
     Internal::ListNode<Tp>* m_head;
     size_t m_size;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
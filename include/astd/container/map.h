@@ -45,6 +45,8 @@ public:
     using key_equal     =   Equal;
     using node_type     =   HashNode<value_type>;
     using allocator     =   Alloc<node_type>;
+    template <typename T>
+    using alloc         =   Alloc<T>;
 
     class value_hash
     {
@@ -77,6 +79,7 @@ class Map : public Internal::RBTree<Internal::MapTrait<Key, Tp, Pred, Alloc, fal
     using Tree = Internal::RBTree<Internal::MapTrait<Key, Tp, Pred, Alloc, false>>;
     using Iterator = typename Tree::Iterator;
 public:
+    using Tree::Tree;
     Tp& operator[](const Key& key)
     {
         auto node = Tree::find_node(key);
@@ -108,6 +111,7 @@ class MultiMap : public Internal::RBTree<Internal::MapTrait<Key, Tp, Pred, Alloc
     using Tree = Internal::RBTree<Internal::MapTrait<Key, Tp, Pred, Alloc, true>>;
     using Iterator = typename Tree::Iterator;
 public:
+    using Tree::Tree;
     Iterator find(const Key& key)
     {
         return Iterator(Tree::find_node(key));
@@ -125,6 +129,7 @@ class BalancedMap : public Internal::AVLTree<Internal::MapTrait<Key, Tp, Pred, A
     using Tree = Internal::AVLTree<Internal::MapTrait<Key, Tp, Pred, Alloc, false>>;
     using Iterator = typename Tree::Iterator;
 public:
+    using Tree::Tree;
     Tp& operator[](const Key& key)
     {
         auto node = Tree::find_node(key);
@@ -156,6 +161,7 @@ class BalancedMultiMap : public Internal::AVLTree<Internal::MapTrait<Key, Tp, Pr
     using Tree = Internal::AVLTree<Internal::MapTrait<Key, Tp, Pred, Alloc, true>>;
     using Iterator = typename Tree::Iterator;
 public:
+    using Tree::Tree;
     Iterator find(const Key& key)
     {
         return Iterator(Tree::find_node(key));
@@ -174,6 +180,7 @@ class HashMap : public Internal::Hash<Internal::HashMapTrait<Key, Tp, Hasher, Eq
     using Hash = Internal::Hash<Internal::HashMapTrait<Key, Tp, Hasher, Equal, Alloc, false>>;
     using Iterator = typename Hash::Iterator;
 public:
+    using Hash::Hash;
     Tp& operator[](const Key& key)
     {
         auto node = Hash::find_node(key);
@@ -208,6 +215,7 @@ class MultiHashMap : public Internal::Hash<Internal::HashMapTrait<Key, Tp, Hashe
     using Hash = Internal::Hash<Internal::HashMapTrait<Key, Tp, Hasher, Equal, Alloc, true>>;
     using Iterator = typename Hash::Iterator;
 public:
+    using Hash::Hash;
     Iterator find(const Key& key)
     {
         return Iterator(Hash::find_node(key));
@@ -9,9 +9,11 @@ class Queue
 {
     using allocator = Alloc<Internal::ListNode<Tp>>;
 public:
-    Queue() : m_size(0)
+    Queue() : Queue(allocator()) {}
+
+    explicit Queue(const allocator& alloc) : m_size(0), m_allocator(alloc)
     {
-        m_head = allocator::allocate(1);
+        m_head = m_allocator.allocate(1);
         m_head->val = Tp();
         m_head->prev = nullptr;
         m_head->next = nullptr;
@@ -21,13 +23,13 @@ public:
     {
         clear();
 
-        allocator::deallocate(m_head);
+        m_allocator.deallocate(m_head);
         m_head = nullptr;
     }
 
     void enqueue(Tp&& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
         node->next = nullptr;
 
@@ -48,7 +50,7 @@ public:
 
     void enqueue(const Tp& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
         node->next = nullptr;
 
@@ -82,7 +84,7 @@ public:
             m_head->next = nullptr;
         }
 
-        allocator::deallocate(node);
+        m_allocator.deallocate(node);
         node = nullptr;
 
         m_size--;
@@ -113,7 +115,7 @@ public:
         {
             Internal::ListNode<Tp>* next = node->next;
 
-            allocator::deallocate(node);
+            m_allocator.deallocate(node);
             node = next;
         }
         m_head->next = nullptr;
@@ -124,6 +126,7 @@ public:
 private:
     Internal::ListNode<Tp>* m_head;
     size_t m_size;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
@@ -22,10 +22,15 @@ class Ring
 {
     using allocator = Alloc<Tp>;
 public:
-    explicit Ring(size_t size = Internal::k_Ring_Buffer_Size) : m_read(0), m_write(0)
+    explicit Ring(size_t size = Internal::k_Ring_Buffer_Size, const allocator& alloc = allocator()) : m_read(0), m_write(0), m_allocator(alloc)
     {
-        m_size = align_to(size, 2ull);
-        m_data = allocator::allocate(m_size);
+        m_size = align_to<size_t>(size, 2);
+        m_data = m_allocator.allocate(m_size);
+    }
+
+    ~Ring()
+    {
+        Alloc<uint8_t>(m_allocator).deallocate(reinterpret_cast<uint8_t*>(m_data));
     }
 
     size_t write(const Tp* buffer, size_t size)
@@ -67,6 +72,7 @@ private:
     size_t                  m_size;
     std::atomic<size_t>     m_read;
     std::atomic<size_t>     m_write;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
@@ -38,6 +38,8 @@ public:
     using key_equal     =   Equal;
     using node_type     =   HashNode<value_type>;
     using allocator     =   Alloc<node_type>;
+    template <typename T>
+    using alloc         =   Alloc<T>;
     using value_hash    =   key_hash;
 
     static constexpr bool is_multi = Multi;
@@ -61,6 +63,7 @@ class Set : public Internal::RBTree<Internal::SetTrait<Tp, Pred, Alloc, false>>
     using Tree = Internal::RBTree<Internal::SetTrait<Tp, Pred, Alloc, false>>;
     using Iterator = typename Tree::Iterator;
 public:
+    using Tree::Tree;
     Set() = default;
 
     template <typename Iter>
@@ -86,6 +89,7 @@ class MultiSet : public Internal::RBTree<Internal::SetTrait<Tp, Pred, Alloc, tru
     using Tree = Internal::RBTree<Internal::SetTrait<Tp, Pred, Alloc, true>>;
     using Iterator = typename Tree::Iterator;
 public:
+    using Tree::Tree;
     Iterator find(const Tp& key)
     {
         return Iterator(Tree::find_node(key));
@@ -105,6 +109,7 @@ class HashSet : public Internal::Hash<Internal::HashSetTrait<Tp, Hasher, Equal,
     using Hash = Internal::Hash<Internal::HashSetTrait<Tp, Hasher, Equal, Alloc, false>>;
     using Iterator = typename Hash::Iterator;
 public:
+    using Hash::Hash;
     Iterator find(const Tp& key)
     {
         return Iterator(Hash::find_node(key));
@@ -122,6 +127,7 @@ class MultiHashSet : public Internal::Hash<Internal::HashSetTrait<Tp, Hasher, Eq
     using Hash = Internal::Hash<Internal::HashSetTrait<Tp, Hasher, Equal, Alloc, true>>;
     using Iterator = typename Hash::Iterator;
 public:
+    using Hash::Hash;
     Iterator find(const Tp& key)
     {
         return Iterator(Hash::find_node(key));
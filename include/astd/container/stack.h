@@ -14,9 +14,11 @@ class Stack
 {
     using allocator = Alloc<Internal::ListNode<Tp>>;
 public:
-    Stack() : m_size(0)
+    Stack() : Stack(allocator()) {}
+
+    explicit Stack(const allocator& alloc) : m_size(0), m_allocator(alloc)
     {
-        m_head = allocator::allocate(1);
+        m_head = m_allocator.allocate(1);
         m_head->val = Tp();
         m_head->prev = nullptr;
         m_head->next = nullptr;
@@ -26,7 +28,7 @@ public:
     {
         clear();
 
-        allocator::deallocate(m_head);
+        m_allocator.deallocate(m_head);
         m_head = nullptr;
     }
 
@@ -39,7 +41,7 @@ public:
 
     void push(const Tp& value)
     {
-        Internal::ListNode<Tp>* node = allocator::allocate(1);
+        Internal::ListNode<Tp>* node = m_allocator.allocate(1);
         node->val = value;
         node->next = nullptr;
 
@@ -73,7 +75,7 @@ public:
             m_head->next = nullptr;
         }
 
-        allocator::deallocate(node);
+        m_allocator.deallocate(node);
         node = nullptr;
 
         m_size--;
@@ -112,7 +114,7 @@ public:
         {
             Internal::ListNode<Tp>* next = node->next;
 
-            allocator::deallocate(node);
+            m_allocator.deallocate(node);
             node = next;
         }
         m_head->next = nullptr;
@@ -123,6 +125,7 @@ public:
 private:
     Internal::ListNode<Tp>* m_head;
     size_t m_size;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 AMAZING_NAMESPACE_END
@@ -37,33 +37,35 @@ class StringT : public Vector<Tp, Alloc>
     using allocator = Alloc<Tp>;
     using allocator_next = Alloc<size_t>;
 public:
-    StringT()
+    StringT() : StringT(allocator()) {}
+
+    explicit StringT(const allocator& alloc) : Str(alloc)
     {
         Str::m_size = 0;
         Str::m_capacity = Str::m_size + 1;
-        Str::m_data = allocator::allocate(Str::m_capacity);
+        Str::m_data = Str::m_allocator.allocate(Str::m_capacity);
         Str::m_data[Str::m_size] = '\0';
     }
 
-    StringT(const Tp* str)
+    StringT(const Tp* str, const allocator& alloc = allocator()) : Str(alloc)
     {
         Str::m_size = str_length(str);
         Str::m_capacity = Str::m_size + 1;
-        Str::m_data = allocator::allocate(Str::m_capacity);
+        Str::m_data = Str::m_allocator.allocate(Str::m_capacity);
         std::memcpy(Str::m_data, str, Str::m_size * sizeof(Tp));
         Str::m_data[Str::m_size] = '\0';
     }
 
-    StringT(const StringT& str)
+    StringT(const StringT& str) : Str(str.m_allocator)
     {
         Str::m_size = str.m_size;
         Str::m_capacity = str.m_capacity;
-        Str::m_data = allocator::allocate(Str::m_capacity);
+        Str::m_data = Str::m_allocator.allocate(Str::m_capacity);
         std::memcpy(Str::m_data, str.m_data, Str::m_size * sizeof(Tp));
         Str::m_data[Str::m_size] = '\0';
     }
 
-    StringT(StringT&& str) noexcept
+    StringT(StringT&& str) noexcept : Str(str.m_allocator)
     {
         Str::swap(str);
     }
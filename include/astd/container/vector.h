@@ -61,7 +61,7 @@ public:
 
         NODISCARD Iterator operator+(int64_t offset) const
         {
-            return m_ptr + offset;
+            return Iterator(m_ptr + offset);
         }
 
         NODISCARD bool operator==(const Iterator& other) const
@@ -79,13 +79,14 @@ public:
     };
 public:
     Vector() : m_data(nullptr), m_size(0), m_capacity(0) {}
-    explicit Vector(const size_t size) : m_data(nullptr), m_size(0), m_capacity(0)
+    explicit Vector(const allocator& alloc) : m_data(nullptr), m_size(0), m_capacity(0), m_allocator(alloc) {}
+    explicit Vector(const size_t size, const allocator& alloc = allocator()) : m_data(nullptr), m_size(0), m_capacity(0), m_allocator(alloc)
     {
         reserve(size);
         m_size = size;
     }
 
-    Vector(const std::initializer_list<Tp>& list) : m_data(nullptr), m_size(list.size()), m_capacity(0)
+    Vector(const std::initializer_list<Tp>& list, const allocator& alloc = allocator()) : m_data(nullptr), m_size(list.size()), m_capacity(0), m_allocator(alloc)
     {
         reserve(m_size);
         if constexpr (copyable<Tp>)
@@ -101,7 +102,7 @@ public:
         }
     }
 
-    Vector(const Vector& other) : m_data(nullptr), m_size(other.m_size), m_capacity(0)
+    Vector(const Vector& other) : m_data(nullptr), m_size(other.m_size), m_capacity(0), m_allocator(other.m_allocator)
     {
         reserve(other.m_capacity);
         if constexpr (copyable<Tp>)
@@ -113,7 +114,7 @@ public:
         }
     }
 
-    Vector(Vector&& other) noexcept : m_data(nullptr), m_size(other.m_size), m_capacity(other.m_capacity)
+    Vector(Vector&& other) noexcept : m_data(nullptr), m_size(0), m_capacity(0), m_allocator(other.m_allocator)
     {
         swap(other);
     }
@@ -126,7 +127,8 @@ public:
                 m_data[i].~Tp();
         }
 
-        deallocate(m_data);
+        // elements are destroyed above, release memory through the same allocator without destroying them again
+        Alloc<uint8_t>(m_allocator).deallocate(reinterpret_cast<uint8_t*>(m_data));
         m_data = nullptr;
         m_size = 0;
         m_capacity = 0;
@@ -230,28 +232,33 @@ public:
 
         if (new_capacity != 0)
         {
-            Tp* new_data = allocator::reallocate(m_data, new_capacity);
+            // usually grows in place, only copy when the allocator has to move the buffer
+            Tp* new_data = m_allocator.reallocate(m_data, new_capacity);
             if (new_data != m_data)
             {
-                if constexpr (copyable<Tp>)
-                    std::memcpy(new_data, m_data, sizeof(Tp) * m_capacity);
-                else if constexpr (movable<Tp>)
+                if (m_data)
                 {
-                    for (size_t i = 0; i < m_capacity; i++)
-                        std::swap(m_data[i], new_data[i]);
+                    size_t count = std::min(m_capacity, new_capacity);
+                    if constexpr (copyable<Tp>)
+                        std::memcpy(new_data, m_data, sizeof(Tp) * count);
+                    else if constexpr (movable<Tp>)
+                    {
+                        for (size_t i = 0; i < count; i++)
+                            std::swap(m_data[i], new_data[i]);
+                    }
+                    else
+                    {
+                        for (size_t i = 0; i < count; i++)
+                            new_data[i] = m_data[i];
+                    }
+                    Alloc<uint8_t>(m_allocator).deallocate(reinterpret_cast<uint8_t*>(m_data));
                 }
-                else
-                {
-                    for (size_t i = 0; i < m_capacity; i++)
-                        new_data[i] = m_data[i];
-                }
-                allocator::deallocate(m_data);
                 m_data = new_data;
             }
         }
         else
         {
-            allocator::deallocate(m_data);
+            m_allocator.deallocate(m_data);
             m_data = nullptr;
         }
 
@@ -273,6 +280,7 @@ public:
         Amazing::swap(m_data, other.m_data);
         Amazing::swap(m_size, other.m_size);
         Amazing::swap(m_capacity, other.m_capacity);
+        Amazing::swap(m_allocator, other.m_allocator);
     }
 
     void clear()
@@ -336,10 +344,16 @@ public:
         return m_data[m_size - 1];
     }
 
+    NODISCARD allocator get_allocator() const
+    {
+        return m_allocator;
+    }
+
 protected:
     Tp* m_data;
     size_t      m_size;
     size_t      m_capacity;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
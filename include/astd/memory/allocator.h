@@ -2,31 +2,66 @@
 
 #include "astd/base/define.h"
 #include <cstring>
+#include <cstddef>
 
 AMAZING_NAMESPACE_BEGIN
 
 constexpr static size_t k_global_memory_size = 256 * 1024 * 1024;   // 256 MB
 constexpr static size_t k_local_memory_size = 128 * 1024 * 1024;    // 64 MB
 constexpr static size_t k_cache_alignment = 64;
+constexpr static size_t k_min_alignment = alignof(std::max_align_t);
 
 
-void* allocate(size_t size, size_t alignment = k_cache_alignment, void* data = nullptr);
-void* reallocate(void* p, size_t size, size_t alignment = k_cache_alignment, void* data = nullptr);
+// smaller alignments are raised to k_min_alignment
+void* allocate(size_t size, size_t alignment = k_min_alignment, void* data = nullptr);
+void* reallocate(void* p, size_t size, size_t alignment = k_min_alignment, void* data = nullptr);
 void deallocate(void* p);
 
+// arena size of thread memory pools created afterwards, ASTD_LOCAL_MEMORY_SIZE sets the initial value,
+// in bytes with an optional K, M or G suffix, k_local_memory_size if it is absent
+void set_local_memory_size(size_t size);
+size_t local_memory_size();
+
+
+// counters are only maintained when built with ASTD_MEMORY_STATISTICS, otherwise they stay zero
+struct MemoryStatistics
+{
+    size_t bytes_in_use;        // live blocks, rounded up to their alignment
+    size_t peak_bytes_in_use;   // high water mark of bytes_in_use
+    size_t allocate_count;
+    size_t reallocate_count;
+    size_t deallocate_count;
+
+    // arena layout, always available
+    size_t bytes_reserved;      // address space of arenas
+    size_t bytes_committed;     // pages made accessible so far
+    size_t free_block_count;    // binned blocks and gaps able to hold a new block
+    size_t largest_free_block;
+};
+
+// pool of calling thread
+MemoryStatistics local_memory_statistics();
+// sum of all thread pools, peak is the sum of each pool's peak,
+// arena layout only covers pools no other thread is using, that is the calling thread's and abandoned ones
+MemoryStatistics global_memory_statistics();
+
 
 template <typename Tp>
 class Allocator
 {
 public:
+    Allocator() = default;
+    template <typename Up>
+    Allocator(const Allocator<Up>&) {}
+
     // only allocate memory, but not initialize
-    static Tp* allocate(size_t count, size_t alignment = k_cache_alignment, void* data = nullptr)
+    static Tp* allocate(size_t count, size_t alignment = alignof(Tp), void* data = nullptr)
     {
         return static_cast<Tp*>(Amazing::allocate(sizeof(Tp) * count, alignment, data));
     }
 
     // allocate memory near p with count, only allocate memory, but not initialize
-    static Tp* reallocate(void* p, size_t count, size_t alignment = k_cache_alignment, void* data = nullptr)
+    static Tp* reallocate(void* p, size_t count, size_t alignment = alignof(Tp), void* data = nullptr)
     {
         return static_cast<Tp*>(Amazing::reallocate(p, sizeof(Tp) * count, alignment, data));
     }
@@ -44,7 +79,95 @@ public:
 };
 
 
-#define PLACEMENT_NEW(type, size, ...) (new (Amazing::allocate(size)) type(__VA_ARGS__))
+// source of memory for PolymorphicAllocator, containers using it can draw from different sources
+class IMemoryResource
+{
+public:
+    virtual ~IMemoryResource() = default;
+
+    virtual void* allocate(size_t size, size_t alignment, void* data) = 0;
+    virtual void* reallocate(void* p, size_t size, size_t alignment, void* data) = 0;
+    virtual void deallocate(void* p) = 0;
+};
+
+// the thread local memory pools, same as Allocator
+IMemoryResource* global_memory_resource();
+
+class IMemoryPool;
+
+// a private memory pool, destroying it releases all its memory at once without visiting blocks,
+// it is not thread safe, guard it together with the containers using it
+class MemoryPoolResource final : public IMemoryResource
+{
+public:
+    explicit MemoryPoolResource(size_t arena_size = local_memory_size());
+    ~MemoryPoolResource() override;
+
+    void* allocate(size_t size, size_t alignment, void* data) override;
+    void* reallocate(void* p, size_t size, size_t alignment, void* data) override;
+    void deallocate(void* p) override;
+
+    NODISCARD MemoryStatistics statistics() const;
+
+    MemoryPoolResource(const MemoryPoolResource&) = delete;
+    MemoryPoolResource& operator=(const MemoryPoolResource&) = delete;
+private:
+    IMemoryPool* m_pool;
+};
+
+
+// stateful allocator, stored in containers and passed on to the allocators of their nodes
+template <typename Tp>
+class PolymorphicAllocator
+{
+public:
+    PolymorphicAllocator() : m_resource(global_memory_resource()) {}
+    PolymorphicAllocator(IMemoryResource* resource) : m_resource(resource) {}
+    template <typename Up>
+    PolymorphicAllocator(const PolymorphicAllocator<Up>& other) : m_resource(other.resource()) {}
+
+    // only allocate memory, but not initialize
+    Tp* allocate(size_t count, size_t alignment = alignof(Tp), void* data = nullptr) const
+    {
+        return static_cast<Tp*>(m_resource->allocate(sizeof(Tp) * count, alignment, data));
+    }
+
+    // allocate memory near p with count, only allocate memory, but not initialize
+    Tp* reallocate(void* p, size_t count, size_t alignment = alignof(Tp), void* data = nullptr) const
+    {
+        return static_cast<Tp*>(m_resource->reallocate(p, sizeof(Tp) * count, alignment, data));
+    }
+
+    void deallocate(Tp* p) const
+    {
+        if (p == nullptr)
+            return;
+
+        if constexpr (std::is_destructible_v<Tp>)
+            p->~Tp();
+
+        m_resource->deallocate(p);
+    }
+
+    NODISCARD IMemoryResource* resource() const
+    {
+        return m_resource;
+    }
+private:
+    IMemoryResource* m_resource;
+};
+
+
+// tag for constructors which take an allocator ahead of forwarded arguments
+struct AllocatorArg
+{
+    explicit AllocatorArg() = default;
+};
+
+inline constexpr AllocatorArg allocator_arg{};
+
+
+#define PLACEMENT_NEW(type, size, ...) (new (Amazing::allocate(size, alignof(type))) type(__VA_ARGS__))
 #define PLACEMENT_DELETE(type, p) {if constexpr (std::is_destructible_v<type>) if (p) p->~type(); Amazing::deallocate(p); p = nullptr;}
 #define STACK_NEW(type, count) static_cast<type*>(alloca((count) * sizeof(type)))
 
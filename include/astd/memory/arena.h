@@ -0,0 +1,118 @@
+#pragma once
+
+#include "allocator.h"
+#include "astd/base/logger.h"
+#include <cstddef>
+#include <algorithm>
+
+AMAZING_NAMESPACE_BEGIN
+
+static constexpr size_t k_monotonic_block_size = 64 * 1024;
+
+
+// scoped monotonic arena, allocation bumps a pointer and memory is only released when the arena is destroyed,
+// while alive it is the current arena of the thread which creates it, so it must be destroyed in reverse order
+// it is also a memory resource, deallocate does nothing
+class MonotonicArena final : public IMemoryResource
+{
+public:
+    explicit MonotonicArena(size_t block_size = k_monotonic_block_size);
+    ~MonotonicArena() override;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t), void* data = nullptr) override;
+    // grow in place if p is the latest allocation, otherwise allocate new memory and leave the copy to caller
+    void* reallocate(void* p, size_t size, size_t alignment = alignof(std::max_align_t), void* data = nullptr) override;
+    void deallocate(void* p) override;
+
+    NODISCARD bool contains(const void* p) const;
+    NODISCARD MonotonicArena* parent() const;
+
+    // innermost arena of calling thread, nullptr if there is none
+    NODISCARD static MonotonicArena* current();
+    // whether p is in a block of a live arena of any thread, only tracked in debug builds, false otherwise
+    NODISCARD static bool is_arena_memory(const void* p);
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+    MonotonicArena(MonotonicArena&&) = delete;
+    MonotonicArena& operator=(MonotonicArena&&) = delete;
+private:
+    struct Block
+    {
+        Block* prev;
+        size_t size;    // include block header
+    };
+
+    void* allocate_block(size_t size, size_t alignment);
+private:
+    Block* m_block;
+    uint8_t* m_cursor;
+    uint8_t* m_last;    // start of the latest allocation
+    size_t m_block_size;
+    MonotonicArena* m_parent;
+};
+
+
+// allocate from the current monotonic arena of calling thread, fall back to the thread local memory pool without one,
+// memory from an arena must not outlive it, nor be released on other threads
+template <typename Tp>
+class MonotonicAllocator
+{
+public:
+    MonotonicAllocator() = default;
+    template <typename Up>
+    MonotonicAllocator(const MonotonicAllocator<Up>&) {}
+
+    // only allocate memory, but not initialize
+    static Tp* allocate(size_t count, size_t alignment = alignof(Tp), void* data = nullptr)
+    {
+        if (MonotonicArena* arena = MonotonicArena::current())
+            return static_cast<Tp*>(arena->allocate(sizeof(Tp) * count, alignment));
+
+        return static_cast<Tp*>(Amazing::allocate(sizeof(Tp) * count, alignment, data));
+    }
+
+    // allocate memory near p with count, only allocate memory, but not initialize,
+    // p stays with whoever it came from, memory allocated outside the current arenas never moves into one
+    static Tp* reallocate(void* p, size_t count, size_t alignment = alignof(Tp), void* data = nullptr)
+    {
+        if (p == nullptr)
+            return allocate(count, alignment, data);
+
+        for (MonotonicArena* arena = MonotonicArena::current(); arena; arena = arena->parent())
+        {
+            if (arena->contains(p))
+                return static_cast<Tp*>(arena->reallocate(p, sizeof(Tp) * count, alignment));
+        }
+
+        return static_cast<Tp*>(Amazing::reallocate(p, sizeof(Tp) * count, alignment, data));
+    }
+
+    static void deallocate(Tp* p)
+    {
+        if (p == nullptr)
+            return;
+
+        if constexpr (std::is_destructible_v<Tp>)
+            p->~Tp();
+
+        for (MonotonicArena* arena = MonotonicArena::current(); arena; arena = arena->parent())
+        {
+            if (arena->contains(p))
+                return;
+        }
+
+#if defined(_DEBUG) || defined(DEBUG)
+        // memory of an arena which is not current here, such as one of another thread, is left to that arena
+        if (MonotonicArena::is_arena_memory(p))
+        {
+            LOG_ERROR("astd", "memory of a monotonic arena must be released on the thread which owns the arena!");
+            return;
+        }
+#endif
+        Amazing::deallocate(p);
+    }
+};
+
+
+AMAZING_NAMESPACE_END
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "allocator.h"
+#include "astd/base/util.h"
 
 AMAZING_NAMESPACE_BEGIN
 
@@ -19,11 +20,14 @@ struct RefCounter
 template<typename Tp, template <typename> typename Alloc>
 class Ptr
 {
+    using allocator = Alloc<Tp>;
     using allocator_counter = Alloc<RefCounter>;
 public:
-    Ptr() : m_ptr(nullptr)
+    Ptr() : Ptr(allocator()) {}
+
+    explicit Ptr(const allocator& alloc) : m_ptr(nullptr), m_allocator(alloc)
     {
-        m_ref = allocator_counter::allocate(1);
+        m_ref = allocator_counter(m_allocator).allocate(1);
         m_ref->use_count = 1;
         m_ref->weak_count = 1;
     }
@@ -38,6 +42,7 @@ public:
 protected:
     Tp* m_ptr;
     RefCounter* m_ref;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 INTERNAL_NAMESPACE_END
@@ -57,9 +62,9 @@ public:
         --Ptr::m_ref->weak_count;
         if (Ptr::m_ref->use_count == 0)
         {
-            allocator::deallocate(Ptr::m_ptr);
+            Ptr::m_allocator.deallocate(Ptr::m_ptr);
             if (Ptr::m_ref->weak_count == 0)
-                allocator_counter::deallocate(Ptr::m_ref);
+                allocator_counter(Ptr::m_allocator).deallocate(Ptr::m_ref);
         }
     }
 
@@ -67,12 +72,22 @@ public:
     requires(std::is_constructible_v<Tp, Args...>)
     explicit SharedPtr(Args&&... args)
     {
-        Tp* p = allocator::allocate(1);
+        Tp* p = Ptr::m_allocator.allocate(1);
+        Ptr::m_ptr = new (p) Tp(std::forward<Args>(args)...);
+    }
+
+    // object and counter are allocated through alloc
+    template <typename... Args>
+    requires(std::is_constructible_v<Tp, Args...>)
+    SharedPtr(AllocatorArg, const allocator& alloc, Args&&... args) : Ptr(alloc)
+    {
+        Tp* p = Ptr::m_allocator.allocate(1);
         Ptr::m_ptr = new (p) Tp(std::forward<Args>(args)...);
     }
 
     SharedPtr(const SharedPtr& rhs)
     {
+        Ptr::m_allocator = rhs.m_allocator;
         Ptr::m_ptr = rhs.m_ptr;
         Ptr::m_ref = rhs.m_ref;
         ++Ptr::m_ref->use_count;
@@ -161,10 +176,11 @@ class UniquePtr
 {
     using allocator = Alloc<Tp>;
 public:
-    explicit UniquePtr(Tp* ptr = nullptr) : m_ptr(ptr) {}
+    // ptr must come from the same kind of allocator
+    explicit UniquePtr(Tp* ptr = nullptr, const allocator& alloc = allocator()) : m_ptr(ptr), m_allocator(alloc) {}
     ~UniquePtr()
     {
-        PLACEMENT_DELETE(Tp, m_ptr);
+        m_allocator.deallocate(m_ptr);
         m_ptr = nullptr;
     }
 
@@ -172,13 +188,30 @@ public:
     requires(std::is_constructible_v<Tp, Args...>)
     explicit UniquePtr(Args&&... args)
     {
-        m_ptr = PLACEMENT_NEW(Tp, sizeof(Tp), std::forward<Args>(args)...);
+        m_ptr = new (m_allocator.allocate(1)) Tp(std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    requires(std::is_constructible_v<Tp, Args...>)
+    UniquePtr(AllocatorArg, const allocator& alloc, Args&&... args) : m_allocator(alloc)
+    {
+        m_ptr = new (m_allocator.allocate(1)) Tp(std::forward<Args>(args)...);
     }
 
     UniquePtr(const UniquePtr&) = delete;
     UniquePtr& operator=(const UniquePtr&) = delete;
-    UniquePtr(UniquePtr&&) = default;
-    UniquePtr& operator=(UniquePtr&&) = default;
+
+    UniquePtr(UniquePtr&& other) noexcept : m_ptr(other.m_ptr), m_allocator(other.m_allocator)
+    {
+        other.m_ptr = nullptr;
+    }
+
+    UniquePtr& operator=(UniquePtr&& other) noexcept
+    {
+        Amazing::swap(m_ptr, other.m_ptr);
+        Amazing::swap(m_allocator, other.m_allocator);
+        return *this;
+    }
 
     NODISCARD Tp* get() const
     {
@@ -192,6 +225,7 @@ public:
 
 private:
     Tp* m_ptr;
+    NO_UNIQUE_ADDRESS allocator m_allocator;
 };
 
 
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "allocator.h"
+#include "astd/base/util.h"
+#include "astd/base/except.h"
+#include <algorithm>
+#include <mutex>
+
+AMAZING_NAMESPACE_BEGIN
+
+static constexpr size_t k_slab_size = 64 * 1024;
+
+INTERNAL_NAMESPACE_BEGIN
+
+// free slots of one slot type shared by all threads, exiting threads leave theirs here
+class SlabDepot
+{
+public:
+    SlabDepot(size_t slot_size, size_t alignment);
+
+    // take the whole list, nullptr if it is empty
+    void* take();
+    // append a list linked by the first word of each slot
+    void give(void* first, void* last);
+
+    NODISCARD size_t slot_size() const { return m_slot_size; }
+    NODISCARD size_t alignment() const { return m_alignment; }
+private:
+    size_t m_slot_size;
+    size_t m_alignment;
+    std::mutex m_mutex;
+    void* m_free;
+};
+
+// free list and untouched range of the latest slab of one slot type in one thread,
+// trivially destructible, so it stays usable while other thread local objects are destroyed
+class SlabCache
+{
+public:
+    void* allocate(SlabDepot& depot)
+    {
+        if (void* p = m_free)
+        {
+            m_free = *static_cast<void**>(p);
+            *static_cast<void**>(p) = nullptr;
+            return p;
+        }
+
+        return refill(depot);
+    }
+
+    // p must be zeroed, except its first word which links the free list
+    void deallocate(void* p, SlabDepot& depot)
+    {
+        if (m_flushed)
+        {
+            depot.give(p, p);
+            return;
+        }
+
+        push(p);
+    }
+
+    // hand all free slots over to depot at thread exit, later slots go straight back to it,
+    // since objects destroyed after the flush would leave them here for good
+    void flush(SlabDepot& depot);
+private:
+    void push(void* p)
+    {
+        *static_cast<void**>(p) = m_free;
+        m_free = p;
+    }
+
+    void* refill(SlabDepot& depot);
+private:
+    void* m_free = nullptr;
+    uint8_t* m_cursor = nullptr;
+    uint8_t* m_end = nullptr;
+    bool m_flushed = false;
+};
+
+class SlabCacheGuard
+{
+public:
+    SlabCacheGuard(SlabCache& cache, SlabDepot& depot) : m_cache(cache), m_depot(depot) {}
+    ~SlabCacheGuard()
+    {
+        m_cache.flush(m_depot);
+    }
+private:
+    SlabCache& m_cache;
+    SlabDepot& m_depot;
+};
+
+INTERNAL_NAMESPACE_END
+
+
+// allocate single objects from slabs without per block header, opt in for nodes of list and tree containers,
+// such as List<Tp, PoolAllocator>, it throws for arrays, so it can't serve vectors or strings,
+// slabs are never returned to memory pool, even after all containers using them are destroyed,
+// freed slots stay reserved for objects of the same size and alignment for the life of the process
+template <typename Tp>
+class PoolAllocator
+{
+public:
+    PoolAllocator() = default;
+    template <typename Up>
+    PoolAllocator(const PoolAllocator<Up>&) {}
+
+    // only allocate memory of one object, but not initialize
+    static Tp* allocate(size_t count, size_t alignment = alignof(Tp), void* = nullptr)
+    {
+        if (count != 1 || alignment > alignof(Tp))
+            throw AStdException(AStdError::NO_VALID_PARAMETER);
+        return static_cast<Tp*>(cache().allocate(depot()));
+    }
+
+    // a slot always holds exactly one object
+    static Tp* reallocate(void* p, size_t count, size_t alignment = alignof(Tp), void* = nullptr)
+    {
+        if (p == nullptr)
+            return allocate(count, alignment);
+
+        if (count != 1)
+            throw AStdException(AStdError::NO_VALID_PARAMETER);
+        return static_cast<Tp*>(p);
+    }
+
+    static void deallocate(Tp* p)
+    {
+        if (p == nullptr)
+            return;
+
+        if constexpr (std::is_destructible_v<Tp>)
+            p->~Tp();
+
+        // keep slots zeroed as fresh memory
+        std::memset(static_cast<void*>(p), 0, sizeof(Tp));
+        cache().deallocate(p, depot());
+    }
+private:
+    static Internal::SlabDepot& depot()
+    {
+        constexpr size_t alignment = std::max(alignof(Tp), alignof(void*));
+        static Internal::SlabDepot s_depot(align_to(std::max(sizeof(Tp), sizeof(void*)), alignment), alignment);
+        return s_depot;
+    }
+
+    static Internal::SlabCache& cache()
+    {
+        static thread_local Internal::SlabCache t_cache;
+        static thread_local Internal::SlabCacheGuard t_guard(t_cache, depot());
+        return t_cache;
+    }
+};
+
+
+AMAZING_NAMESPACE_END
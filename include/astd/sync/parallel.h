@@ -8,6 +8,7 @@
 #include "astd/sync/task/task.h"
 #include "astd/sync/task/executor.h"
 #include "astd/algorithm/iter.h"
+#include "astd/base/util.h"
 
 AMAZING_NAMESPACE_BEGIN
 
@@ -17,6 +18,252 @@ enum class ParallelStrategy
     e_sequential,
 };
 
+// how parallel_for hands index ranges to workers
+enum class Partitioner
+{
+    // split the range in halves recursively, then one task per piece
+    e_static,
+    // workers grab pieces of grain size from a shared cursor
+    e_dynamic,
+    // like dynamic, but pieces shrink with the remaining range, down to grain size
+    e_guided,
+};
+
+// containers shorter than this are sorted by a single thread
+static constexpr size_t k_parallel_sort_threshold = 16 * 1024;
+
+// let parallel_for pick grain size from range size and thread count
+static constexpr size_t k_auto_grain_size = 0;
+// pieces per worker taken by automatic grain size, so faster workers take more of them
+static constexpr size_t k_pieces_per_worker = 8;
+
+INTERNAL_NAMESPACE_BEGIN
+
+struct IndexRange
+{
+    size_t first;
+    size_t last;
+};
+
+inline void split_range(Vector<IndexRange>& ranges, size_t first, size_t last, size_t chunk_size)
+{
+    if (last - first <= chunk_size)
+    {
+        ranges.push_back(IndexRange{first, last});
+        return;
+    }
+
+    size_t middle = first + (last - first) / 2;
+    split_range(ranges, first, middle, chunk_size);
+    split_range(ranges, middle, last, chunk_size);
+}
+
+// about k_pieces_per_worker pieces per worker, or a single piece where tasks would not help
+inline Vector<IndexRange> split_pieces(Executor& executor, size_t count)
+{
+    Vector<IndexRange> ranges;
+    size_t thread_count = executor.thread_count();
+    if (thread_count == 1)
+        ranges.push_back(IndexRange{0, count});
+    else
+        split_range(ranges, 0, count, std::max<size_t>(division_up(count, thread_count * k_pieces_per_worker), 1));
+    return ranges;
+}
+
+// call f(piece, ranges[piece]) for every piece with workers of executor, ranges must not change meanwhile,
+// on a worker of executor, the pieces of a nested loop are stolen by idle workers while the caller runs tasks
+template <typename F>
+void run_pieces(Executor& executor, Vector<IndexRange> const& ranges, F& f)
+{
+    if (ranges.size() == 1)
+    {
+        for (size_t i = 0; i < ranges.size(); ++i)
+            f(i, ranges[i]);
+        return;
+    }
+
+    TaskGraph graph(static_cast<uint32_t>(ranges.size()));
+    for (size_t i = 0; i < ranges.size(); ++i)
+        graph.emplace([&f, &ranges, i] { f(i, ranges[i]); });
+
+    executor.run(graph).wait();
+}
+
+// per piece result, padded so neighbouring pieces do not share a cache line
+template <typename Tp>
+struct alignas(k_cache_alignment) Partial
+{
+    Tp value;
+};
+
+// combine partials pairwise in a tree, keeping their order, the result is left in the first one
+template <typename Tp, typename Op>
+void combine_partials(Vector<Partial<Tp>>& partials, Op& op)
+{
+    for (size_t stride = 1; stride < partials.size(); stride *= 2)
+    {
+        for (size_t i = 0; i + stride < partials.size(); i += stride * 2)
+            partials[i].value = op(partials[i].value, partials[i + stride].value);
+    }
+}
+
+// call f(first + i) for i in [0, count), with no more than one task per piece
+template <typename Index, typename F>
+void parallel_for_range(Executor& executor, Index first, size_t count, F& f, size_t grain_size, Partitioner partitioner)
+{
+    size_t thread_count = executor.thread_count();
+    if (grain_size == k_auto_grain_size)
+        grain_size = std::max<size_t>(count / (thread_count * k_pieces_per_worker), 1);
+
+    auto run_range = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            f(static_cast<Index>(first + static_cast<Index>(i)));
+    };
+
+    // small ranges are not worth a task
+    if (thread_count == 1 || count <= grain_size)
+    {
+        run_range(0, count);
+        return;
+    }
+
+    Vector<IndexRange> ranges;
+    alignas(k_cache_alignment) std::atomic<size_t> cursor(0);
+    auto run_piece = [&](size_t, IndexRange const& range)
+    {
+        switch (partitioner)
+        {
+        case Partitioner::e_static:
+            run_range(range.first, range.last);
+            break;
+        case Partitioner::e_dynamic:
+            for (size_t begin = cursor.fetch_add(grain_size, std::memory_order_relaxed); begin < count;
+                 begin = cursor.fetch_add(grain_size, std::memory_order_relaxed))
+                run_range(begin, std::min(begin + grain_size, count));
+            break;
+        case Partitioner::e_guided:
+        {
+            size_t begin = cursor.load(std::memory_order_relaxed);
+            while (begin < count)
+            {
+                size_t remain = count - begin;
+                size_t size = std::min(std::max(remain / (thread_count * 2), grain_size), remain);
+                if (cursor.compare_exchange_weak(begin, begin + size, std::memory_order_relaxed))
+                {
+                    run_range(begin, begin + size);
+                    begin = cursor.load(std::memory_order_relaxed);
+                }
+            }
+            break;
+        }
+        }
+    };
+
+    // dynamic and guided pieces only stand for workers, they take their ranges from the cursor
+    if (partitioner == Partitioner::e_static)
+        split_range(ranges, 0, count, std::max(division_up(count, thread_count), grain_size));
+    else
+        ranges.resize(std::min(thread_count, division_up(count, grain_size)));
+
+    run_pieces(executor, ranges, run_piece);
+}
+
+
+// number of elements of a stable merge of a and b taken from a, when count elements are output
+template <typename Tp, typename Pred>
+size_t merge_rank(const Tp* a, size_t a_count, const Tp* b, size_t b_count, size_t count, Pred& pred)
+{
+    size_t low = count > b_count ? count - b_count : 0;
+    size_t high = std::min(count, a_count);
+    while (low < high)
+    {
+        size_t i = low + (high - low) / 2;
+        size_t j = count - i;
+        // equal elements of a go first, take more of a while b[j - 1] is not less than a[i]
+        if (j > 0 && i < a_count && !pred(b[j - 1], a[i]))
+            low = i + 1;
+        else
+            high = i;
+    }
+    return low;
+}
+
+// move elements [first, last) of the stable merge of a and b to output,
+// which is raw storage to construct them in with Construct, or holds elements to assign otherwise
+template <bool Construct, typename Tp, typename Pred>
+void merge_range(Tp* a, size_t a_count, Tp* b, size_t b_count, size_t first, size_t last, Tp* output, Pred& pred)
+{
+    auto put = [&output](Tp& value)
+    {
+        if constexpr (Construct)
+            new (output++) Tp(std::move(value));
+        else
+            *output++ = std::move(value);
+    };
+
+    size_t i = merge_rank(a, a_count, b, b_count, first, pred);
+    size_t j = first - i;
+    size_t i_last = merge_rank(a, a_count, b, b_count, last, pred);
+    size_t j_last = last - i_last;
+    while (i < i_last && j < j_last)
+    {
+        if (pred(b[j], a[i]))
+            put(b[j++]);
+        else
+            put(a[i++]);
+    }
+    while (i < i_last)
+        put(a[i++]);
+    while (j < j_last)
+        put(b[j++]);
+}
+
+INTERNAL_NAMESPACE_END
+
+// call f(i) for every index in [first, last), indices are grouped into pieces of at least grain size,
+// so per index cost is a plain loop iteration
+template <typename Index, typename F>
+    requires(std::is_integral_v<Index>)
+void parallel_for(Executor& executor, Index first, Index last, F&& f, size_t grain_size = k_auto_grain_size, Partitioner partitioner = Partitioner::e_guided)
+{
+    if (last <= first)
+        return;
+
+    Internal::parallel_for_range(executor, first, static_cast<size_t>(last - first), f, grain_size, partitioner);
+}
+
+template <typename Index, typename F>
+    requires(std::is_integral_v<Index>)
+void parallel_for(Index first, Index last, F&& f, size_t grain_size = k_auto_grain_size, Partitioner partitioner = Partitioner::e_guided)
+{
+    parallel_for(default_executor(), first, last, std::forward<F>(f), grain_size, partitioner);
+}
+
+// call f(item) for every item of a random access container
+template <typename Container, typename F>
+void parallel_for(Executor& executor, Container& container, F&& f, size_t grain_size = k_auto_grain_size, Partitioner partitioner = Partitioner::e_guided)
+{
+    parallel_for(executor, static_cast<size_t>(0), static_cast<size_t>(container.size()), [&](size_t i)
+    {
+        f(container[i]);
+    }, grain_size, partitioner);
+}
+
+template <typename Container, typename F>
+void parallel_for(Container& container, F&& f, size_t grain_size = k_auto_grain_size, Partitioner partitioner = Partitioner::e_guided)
+{
+    parallel_for(default_executor(), container, std::forward<F>(f), grain_size, partitioner);
+}
+
+// run f on every item with workers of executor, return after all of them are finished,
+// items are grouped into pieces like parallel_for with the default partitioner
+template <typename Container, typename F>
+void for_each(Executor& executor, Container const& container, F&& f)
+{
+    parallel_for(executor, container, std::forward<F>(f));
+}
+
 template <typename Container, typename F>
 void for_each(ParallelStrategy strategy, Container const& container, F&& f)
 {
@@ -26,21 +273,355 @@ void for_each(ParallelStrategy strategy, Container const& container, F&& f)
         for_each(begin(container), end(container), std::forward<F>(f));
         break;
     case ParallelStrategy::e_parallel:
+        for_each(default_executor(), container, std::forward<F>(f));
+        break;
+    }
+}
+
+// op must be associative, pieces are reduced in parallel and combined in order
+template <typename Container, typename Tp, typename ReduceOp, typename TransformOp>
+Tp transform_reduce(Executor& executor, Container const& container, Tp init, ReduceOp&& reduce_op, TransformOp&& transform_op)
+{
+    size_t count = container.size();
+    if (count == 0)
+        return init;
+
+    Vector<Internal::IndexRange> ranges = Internal::split_pieces(executor, count);
+    Vector<Internal::Partial<Tp>> partials;
+    partials.resize(ranges.size());
+    auto reduce_piece = [&](size_t piece, Internal::IndexRange const& range)
+    {
+        Tp sum = transform_op(container[range.first]);
+        for (size_t i = range.first + 1; i < range.last; ++i)
+            sum = reduce_op(sum, transform_op(container[i]));
+        partials[piece].value = sum;
+    };
+
+    Internal::run_pieces(executor, ranges, reduce_piece);
+    Internal::combine_partials(partials, reduce_op);
+    return reduce_op(init, partials[0].value);
+}
+
+template <typename Container, typename Tp, typename ReduceOp, typename TransformOp>
+Tp transform_reduce(ParallelStrategy strategy, Container const& container, Tp init, ReduceOp&& reduce_op, TransformOp&& transform_op)
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        return transform_reduce(container, init, std::forward<ReduceOp>(reduce_op), std::forward<TransformOp>(transform_op));
+
+    return transform_reduce(default_executor(), container, init, std::forward<ReduceOp>(reduce_op), std::forward<TransformOp>(transform_op));
+}
+
+template <typename Container, typename Tp, typename Op>
+Tp reduce(Executor& executor, Container const& container, Tp init, Op&& op)
+{
+    return transform_reduce(executor, container, init, std::forward<Op>(op), [](auto const& item) -> decltype(auto) { return item; });
+}
+
+template <typename Container, typename Tp, typename Op>
+Tp reduce(ParallelStrategy strategy, Container const& container, Tp init, Op&& op)
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        return reduce(container, init, std::forward<Op>(op));
+
+    return reduce(default_executor(), container, init, std::forward<Op>(op));
+}
+
+template <typename Container, typename F>
+size_t count_if(Executor& executor, Container const& container, F&& f)
+{
+    return transform_reduce(executor, container, static_cast<size_t>(0), [](size_t lhs, size_t rhs) { return lhs + rhs; },
+                            [&](auto const& item) -> size_t { return f(item) ? 1 : 0; });
+}
+
+template <typename Container, typename F>
+size_t count_if(ParallelStrategy strategy, Container const& container, F&& f)
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        return count_if(container, std::forward<F>(f));
+
+    return count_if(default_executor(), container, std::forward<F>(f));
+}
+
+// the first smallest element, end if the container is empty
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+typename Container::Iterator min_element(Executor& executor, Container& container, Pred predicate = Pred())
+{
+    size_t count = container.size();
+    if (count == 0)
+        return end(container);
+
+    // partials hold indices of the smallest element of each piece
+    Vector<Internal::IndexRange> ranges = Internal::split_pieces(executor, count);
+    Vector<Internal::Partial<size_t>> partials;
+    partials.resize(ranges.size());
+    auto reduce_piece = [&](size_t piece, Internal::IndexRange const& range)
+    {
+        size_t ret = range.first;
+        for (size_t i = range.first + 1; i < range.last; ++i)
+        {
+            if (predicate(container[i], container[ret]))
+                ret = i;
+        }
+        partials[piece].value = ret;
+    };
+    auto pick = [&](size_t lhs, size_t rhs)
+    {
+        return predicate(container[rhs], container[lhs]) ? rhs : lhs;
+    };
+
+    Internal::run_pieces(executor, ranges, reduce_piece);
+    Internal::combine_partials(partials, pick);
+    return begin(container) + static_cast<int64_t>(partials[0].value);
+}
+
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+typename Container::Iterator min_element(ParallelStrategy strategy, Container& container, Pred predicate = Pred())
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        return min_element(container, predicate);
+
+    return min_element(default_executor(), container, predicate);
+}
+
+// the first largest element, end if the container is empty
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+typename Container::Iterator max_element(Executor& executor, Container& container, Pred predicate = Pred())
+{
+    size_t count = container.size();
+    if (count == 0)
+        return end(container);
+
+    Vector<Internal::IndexRange> ranges = Internal::split_pieces(executor, count);
+    Vector<Internal::Partial<size_t>> partials;
+    partials.resize(ranges.size());
+    auto reduce_piece = [&](size_t piece, Internal::IndexRange const& range)
+    {
+        size_t ret = range.first;
+        for (size_t i = range.first + 1; i < range.last; ++i)
+        {
+            if (predicate(container[ret], container[i]))
+                ret = i;
+        }
+        partials[piece].value = ret;
+    };
+    auto pick = [&](size_t lhs, size_t rhs)
+    {
+        return predicate(container[lhs], container[rhs]) ? rhs : lhs;
+    };
+
+    Internal::run_pieces(executor, ranges, reduce_piece);
+    Internal::combine_partials(partials, pick);
+    return begin(container) + static_cast<int64_t>(partials[0].value);
+}
+
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+typename Container::Iterator max_element(ParallelStrategy strategy, Container& container, Pred predicate = Pred())
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        return max_element(container, predicate);
+
+    return max_element(default_executor(), container, predicate);
+}
+
+// sums of pieces first, then scan of the sums, at last every piece scans starting from the sum before it,
+// op must be associative, output must have at least as many elements as input and may be the input itself
+template <typename Container, typename OutContainer, typename Op>
+void inclusive_scan(Executor& executor, Container const& input, OutContainer& output, Op&& op)
+{
+    using Tp = std::decay_t<decltype(input[0])>;
+
+    size_t count = input.size();
+    if (count == 0)
+        return;
+
+    Vector<Internal::IndexRange> ranges = Internal::split_pieces(executor, count);
+    Vector<Internal::Partial<Tp>> partials;
+    partials.resize(ranges.size());
+    auto reduce_piece = [&](size_t piece, Internal::IndexRange const& range)
     {
-        TaskGraph graph(container.size());
-        for_each(begin(container), end(container), [&](auto&& item)
+        Tp sum = input[range.first];
+        for (size_t i = range.first + 1; i < range.last; ++i)
+            sum = op(sum, input[i]);
+        partials[piece].value = sum;
+    };
+    auto scan_piece = [&](size_t piece, Internal::IndexRange const& range)
+    {
+        Tp sum = piece == 0 ? input[range.first] : op(partials[piece - 1].value, input[range.first]);
+        output[range.first] = sum;
+        for (size_t i = range.first + 1; i < range.last; ++i)
         {
-            graph.emplace(std::forward<F>(f), item);
-        });
+            sum = op(sum, input[i]);
+            output[i] = sum;
+        }
+    };
+
+    if (ranges.size() > 1)
+    {
+        Internal::run_pieces(executor, ranges, reduce_piece);
+        for (size_t i = 1; i < partials.size(); ++i)
+            partials[i].value = op(partials[i - 1].value, partials[i].value);
+    }
+    Internal::run_pieces(executor, ranges, scan_piece);
+}
+
+template <typename Container, typename OutContainer, typename Op>
+void inclusive_scan(ParallelStrategy strategy, Container const& input, OutContainer& output, Op&& op)
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        inclusive_scan(input, output, std::forward<Op>(op));
+    else
+        inclusive_scan(default_executor(), input, output, std::forward<Op>(op));
+}
 
-        UniquePtr<Executor> executor = UniquePtr<Executor>(PLACEMENT_NEW(Executor, sizeof(Executor), std::thread::hardware_concurrency()));
+template <typename Container, typename OutContainer, typename Tp, typename Op>
+void exclusive_scan(Executor& executor, Container const& input, OutContainer& output, Tp init, Op&& op)
+{
+    size_t count = input.size();
+    if (count == 0)
+        return;
 
-        executor->run(graph);
-        executor->wait();
+    Vector<Internal::IndexRange> ranges = Internal::split_pieces(executor, count);
+    Vector<Internal::Partial<Tp>> partials;
+    partials.resize(ranges.size());
+    auto reduce_piece = [&](size_t piece, Internal::IndexRange const& range)
+    {
+        Tp sum = input[range.first];
+        for (size_t i = range.first + 1; i < range.last; ++i)
+            sum = op(sum, input[i]);
+        partials[piece].value = sum;
+    };
+    auto scan_piece = [&](size_t piece, Internal::IndexRange const& range)
+    {
+        Tp sum = partials[piece].value;
+        for (size_t i = range.first; i < range.last; ++i)
+        {
+            Tp next = op(sum, input[i]);
+            output[i] = sum;
+            sum = next;
+        }
+    };
+
+    // turn sums of pieces into the sum before each piece
+    if (ranges.size() > 1)
+    {
+        Internal::run_pieces(executor, ranges, reduce_piece);
+        for (size_t i = 0; i < partials.size(); ++i)
+        {
+            Tp next = op(init, partials[i].value);
+            partials[i].value = init;
+            init = next;
+        }
     }
+    else
+        partials[0].value = init;
+    Internal::run_pieces(executor, ranges, scan_piece);
+}
+
+template <typename Container, typename OutContainer, typename Tp, typename Op>
+void exclusive_scan(ParallelStrategy strategy, Container const& input, OutContainer& output, Tp init, Op&& op)
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        exclusive_scan(input, output, init, std::forward<Op>(op));
+    else
+        exclusive_scan(default_executor(), input, output, init, std::forward<Op>(op));
+}
+
+// merge sort for containers with contiguous storage, pieces are sorted by single threads, then merged pairwise,
+// every merge is split by output position so all workers take part until the last one,
+// the sort is unstable, equal elements may change their order, and elements only need to be movable
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+void sort(Executor& executor, Container& container, Pred predicate = Pred())
+{
+    using Tp = std::remove_reference_t<decltype(container[0])>;
+
+    size_t count = container.size();
+    if (count < 2)
+        return;
+
+    Vector<Internal::IndexRange> runs = Internal::split_pieces(executor, count);
+    if (count < k_parallel_sort_threshold || runs.size() == 1)
+    {
+        sort(container, predicate);
+        return;
+    }
+
+    Tp* source = &container[0];
+    auto sort_piece = [&](size_t, Internal::IndexRange const& range)
+    {
+        Internal::sort_unchecked(source + range.first, source + range.last, predicate);
+    };
+    Internal::run_pieces(executor, runs, sort_piece);
+
+    // the first round move constructs every element of the buffer, later rounds move assign
+    Tp* buffer = static_cast<Tp*>(Amazing::allocate(sizeof(Tp) * count, alignof(Tp)));
+    Tp* target = buffer;
+    bool constructed = false;
+    size_t chunk_size = division_up(count, executor.thread_count() * k_pieces_per_worker);
+    while (runs.size() > 1)
+    {
+        // chunks of output and the pair of runs each of them is merged from, an odd run is merged with nothing
+        Vector<Internal::IndexRange> merged_runs;
+        Vector<Internal::IndexRange> chunks;
+        Vector<size_t> chunk_runs;
+        for (size_t i = 0; i < runs.size(); i += 2)
+        {
+            Internal::IndexRange merged{runs[i].first, i + 1 < runs.size() ? runs[i + 1].last : runs[i].last};
+            merged_runs.push_back(merged);
+            for (size_t first = merged.first; first < merged.last; first += chunk_size)
+            {
+                chunks.push_back(Internal::IndexRange{first, std::min(first + chunk_size, merged.last)});
+                chunk_runs.push_back(i);
+            }
+        }
+
+        auto merge_chunk = [&](size_t piece, Internal::IndexRange const& range)
+        {
+            size_t index = chunk_runs[piece];
+            Internal::IndexRange left = runs[index];
+            Internal::IndexRange right = index + 1 < runs.size() ? runs[index + 1] : Internal::IndexRange{left.last, left.last};
+            if (constructed)
+                Internal::merge_range<false>(source + left.first, left.last - left.first, source + right.first, right.last - right.first,
+                                             range.first - left.first, range.last - left.first, target + range.first, predicate);
+            else
+                Internal::merge_range<true>(source + left.first, left.last - left.first, source + right.first, right.last - right.first,
+                                            range.first - left.first, range.last - left.first, target + range.first, predicate);
+        };
+        Internal::run_pieces(executor, chunks, merge_chunk);
+        constructed = true;
+
+        swap(source, target);
+        runs = std::move(merged_runs);
+    }
+
+    // sorted elements end up in the buffer after an odd number of rounds
+    if (source != &container[0])
+    {
+        Tp* output = &container[0];
+        Vector<Internal::IndexRange> ranges = Internal::split_pieces(executor, count);
+        auto move_piece = [&](size_t, Internal::IndexRange const& range)
+        {
+            for (size_t i = range.first; i < range.last; ++i)
+                output[i] = std::move(source[i]);
+        };
+        Internal::run_pieces(executor, ranges, move_piece);
     }
+
+    if constexpr (!std::is_trivially_destructible_v<Tp>)
+    {
+        for (size_t i = 0; i < count; ++i)
+            buffer[i].~Tp();
+    }
+    Amazing::deallocate(buffer);
 }
 
+template <typename Container, typename Pred = Less<typename Container::Iterator::value_type>>
+void sort(ParallelStrategy strategy, Container& container, Pred predicate = Pred())
+{
+    if (strategy == ParallelStrategy::e_sequential)
+        sort(container, predicate);
+    else
+        sort(default_executor(), container, predicate);
+}
 
 AMAZING_NAMESPACE_END
 
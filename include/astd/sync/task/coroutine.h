@@ -0,0 +1,217 @@
+//
+// Created by AmazingBuff on 2025/10/17.
+//
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include "astd/sync/task/executor.h"
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+AMAZING_NAMESPACE_BEGIN
+
+template <typename T>
+class Coroutine;
+
+INTERNAL_NAMESPACE_BEGIN
+
+// frames come from the memory pool, they are usually resumed and destroyed on different workers
+struct CoroutineFrame
+{
+    static void* operator new(size_t size)
+    {
+        return Amazing::allocate(size);
+    }
+
+    static void operator delete(void* p)
+    {
+        Amazing::deallocate(p);
+    }
+};
+
+class CoroutinePromiseBase : public CoroutineFrame
+{
+    // the awaiting coroutine continues on the thread which finishes this one
+    struct FinalAwaiter
+    {
+        NODISCARD bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().m_continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+public:
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    void unhandled_exception()
+    {
+        m_exception = std::current_exception();
+    }
+protected:
+    void rethrow() const
+    {
+        if (m_exception)
+            std::rethrow_exception(m_exception);
+    }
+private:
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_exception;
+
+    template <typename T>
+    friend class Amazing::Coroutine;
+};
+
+template <typename T>
+class CoroutinePromise final : public CoroutinePromiseBase
+{
+public:
+    Coroutine<T> get_return_object();
+
+    template <typename U = T>
+        requires(std::is_convertible_v<U&&, T>)
+    void return_value(U&& value)
+    {
+        m_value.emplace(std::forward<U>(value));
+    }
+
+    T result()
+    {
+        rethrow();
+        return std::move(*m_value);
+    }
+private:
+    std::optional<T> m_value;
+};
+
+template <>
+class CoroutinePromise<void> final : public CoroutinePromiseBase
+{
+public:
+    Coroutine<void> get_return_object();
+
+    void return_void() const noexcept {}
+
+    void result() const
+    {
+        rethrow();
+    }
+};
+
+// started at once and destroyed at its end, drives a spawned coroutine
+struct DetachedCoroutine
+{
+    struct promise_type : CoroutineFrame
+    {
+        DetachedCoroutine get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        // nobody could observe the exception of a spawned coroutine
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+INTERNAL_NAMESPACE_END
+
+
+// lazily started coroutine which owns its frame, co_await on it starts it and continues when it returns,
+// an exception thrown by it is rethrown to the awaiting coroutine
+template <typename T = void>
+class Coroutine
+{
+public:
+    using promise_type = Internal::CoroutinePromise<T>;
+
+    Coroutine() = default;
+    explicit Coroutine(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    Coroutine(Coroutine&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    Coroutine& operator=(Coroutine&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Coroutine()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    NODISCARD bool valid() const
+    {
+        return static_cast<bool>(m_handle);
+    }
+
+    NODISCARD bool done() const
+    {
+        return m_handle && m_handle.done();
+    }
+
+    NODISCARD bool await_ready() const noexcept
+    {
+        return m_handle.done();
+    }
+
+    // symmetric transfer, so chains of awaiting coroutines never grow the stack
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().m_continuation = awaiting;
+        return m_handle;
+    }
+
+    T await_resume()
+    {
+        return m_handle.promise().result();
+    }
+
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template <typename T>
+Coroutine<T> Internal::CoroutinePromise<T>::get_return_object()
+{
+    return Coroutine<T>(std::coroutine_handle<CoroutinePromise>::from_promise(*this));
+}
+
+inline Coroutine<void> Internal::CoroutinePromise<void>::get_return_object()
+{
+    return Coroutine<void>(std::coroutine_handle<CoroutinePromise>::from_promise(*this));
+}
+
+
+template <typename T>
+void Executor::spawn(Coroutine<T> coroutine)
+{
+    ASSERT(coroutine.valid() && !coroutine.done(), "astd", "coroutine to spawn must not be started!");
+    m_counter.fetch_add(1, std::memory_order_relaxed);
+    drive(*this, std::move(coroutine));
+}
+
+template <typename T>
+Internal::DetachedCoroutine Executor::drive(Executor& executor, Coroutine<T> coroutine)
+{
+    co_await executor.schedule();
+    co_await coroutine;
+    executor.finish_run();
+}
+
+AMAZING_NAMESPACE_END
+#endif //COROUTINE_H
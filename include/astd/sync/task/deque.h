@@ -0,0 +1,144 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include "astd/container/vector.h"
+#include <atomic>
+
+AMAZING_NAMESPACE_BEGIN
+
+static constexpr int64_t k_deque_initial_capacity = 256;
+
+// chase-lev work stealing deque, only owner thread pushes and pops at the bottom,
+// any thread steals from the top, Tp must be trivially copyable, such as a pointer,
+// ordering is carried by the operations on top and bottom themselves rather than by fences,
+// a thief acquires what the owner released with bottom, and pop and steal agree on the last element through seq_cst
+template <typename Tp>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable_v<Tp>, "element of work stealing deque must be trivially copyable!");
+
+    struct Array
+    {
+        int64_t capacity;
+        int64_t mask;
+        std::atomic<Tp>* data;
+
+        static Array* create(int64_t capacity)
+        {
+            Array* array = static_cast<Array*>(Amazing::allocate(sizeof(Array) + sizeof(std::atomic<Tp>) * capacity, alignof(Array)));
+            array->capacity = capacity;
+            array->mask = capacity - 1;
+            array->data = reinterpret_cast<std::atomic<Tp>*>(array + 1);
+            return array;
+        }
+
+        void put(int64_t index, Tp value)
+        {
+            data[index & mask].store(value, std::memory_order_relaxed);
+        }
+
+        Tp get(int64_t index) const
+        {
+            return data[index & mask].load(std::memory_order_relaxed);
+        }
+    };
+public:
+    explicit WorkStealingDeque(int64_t capacity = k_deque_initial_capacity) : m_top(0), m_bottom(0)
+    {
+        ASSERT((capacity & (capacity - 1)) == 0, "astd", "deque capacity must be power of 2!");
+        m_array.store(Array::create(capacity), std::memory_order_relaxed);
+    }
+
+    ~WorkStealingDeque()
+    {
+        for (Array* array : m_garbage)
+            Amazing::deallocate(array);
+        Amazing::deallocate(m_array.load(std::memory_order_relaxed));
+    }
+
+    // owner only
+    void push(Tp value)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        Array* array = m_array.load(std::memory_order_relaxed);
+        if (bottom - top > array->capacity - 1)
+            array = grow(array, top, bottom);
+
+        array->put(bottom, value);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // owner only, false if empty
+    bool pop(Tp& value)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* array = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_seq_cst);
+
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = array->get(bottom);
+        if (top == bottom)
+        {
+            // the last element, race against thieves
+            bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    // any thread, false if empty or lost a race
+    bool steal(Tp& value)
+    {
+        int64_t top = m_top.load(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+        if (top >= bottom)
+            return false;
+
+        Array* array = m_array.load(std::memory_order_acquire);
+        value = array->get(top);
+        return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    NODISCARD bool empty() const
+    {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+    NODISCARD size_t size() const
+    {
+        int64_t size = m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_relaxed);
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+private:
+    Array* grow(Array* array, int64_t top, int64_t bottom)
+    {
+        Array* new_array = Array::create(array->capacity * 2);
+        for (int64_t i = top; i < bottom; ++i)
+            new_array->put(i, array->get(i));
+
+        // thieves may still read the old array, keep it until the deque is destroyed
+        m_garbage.push_back(array);
+        m_array.store(new_array, std::memory_order_release);
+        return new_array;
+    }
+private:
+    alignas(k_cache_alignment) std::atomic<int64_t> m_top;
+    alignas(k_cache_alignment) std::atomic<int64_t> m_bottom;
+    alignas(k_cache_alignment) std::atomic<Array*> m_array;
+    Vector<Array*> m_garbage;
+};
+
+AMAZING_NAMESPACE_END
+#endif //DEQUE_H
@@ -6,56 +6,261 @@
 #define EXECUTOR_H
 
 #include "astd/sync/thread/thread.h"
+#include "astd/sync/task/deque.h"
+#include "astd/sync/task/task.h"
 #include "astd/container/vector.h"
-#include "astd/container/queue.h"
 #include "astd/memory/pointer.h"
+#include <chrono>
+#include <coroutine>
 #include <mutex>
 
 AMAZING_NAMESPACE_BEGIN
 
-class Task;
-class TaskGraph;
 class Executor;
+class Timer;
+
+template <typename T>
+class Coroutine;
+
+INTERNAL_NAMESPACE_BEGIN
+
+struct DetachedCoroutine;
+
+// queues hold suspended coroutines beside tasks, frames are aligned, so the lowest bit tells them apart
+static constexpr uintptr_t k_coroutine_tag = 1;
+
+inline Task* tag_coroutine(std::coroutine_handle<> handle)
+{
+    return reinterpret_cast<Task*>(reinterpret_cast<uintptr_t>(handle.address()) | k_coroutine_tag);
+}
+
+inline bool is_coroutine(Task* task)
+{
+    return (reinterpret_cast<uintptr_t>(task) & k_coroutine_tag) != 0;
+}
+
+inline std::coroutine_handle<> untag_coroutine(Task* task)
+{
+    return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(task) & ~k_coroutine_tag));
+}
+
+INTERNAL_NAMESPACE_END
+
+// records of one worker, only filled when built with ASTD_EXECUTOR_PROFILING, times are in nanoseconds since
+// the executor is created
+struct WorkerProfile
+{
+    enum class Kind : uint8_t
+    {
+        e_task,
+        e_coroutine,
+        e_idle
+    };
+
+    struct Event
+    {
+        const char* name;
+        uint64_t ready;
+        uint64_t begin;
+        uint64_t end;
+        Kind kind;
+    };
+
+    // appended only by the worker itself
+    Vector<Event> events;
+    uint64_t steals = 0;
+    uint64_t failed_steals = 0;
+    uint64_t parks = 0;
+};
 
 class Worker final : public Thread
 {
 public:
-    explicit Worker(Executor* executor);
-
-    Worker(Worker&&) = default;
-    Worker& operator=(Worker&&) = default;
+    Worker(Executor* executor, uint32_t index);
 private:
     void run(std::stop_token token) override;
+    // run a task, or resume a coroutine queued by the executor
+    void execute(Task* task);
+    // release successors of a finished task and count it for its graph
+    void complete(Task* task);
+    void finish(TaskGraph* graph, GraphCompletion completion, Task* parent);
+    // take a task from other workers or the injection queue
+    Task* steal();
+    // keep stealing for a while, then sleep until new tasks are pushed, nullptr if woken up without one
+    Task* park(const std::stop_token& token);
 private:
     Executor* m_ref_executor;
+    uint32_t m_index;
+    uint32_t m_seed;
+    // tasks made ready by this worker, others steal from the top
+    WorkStealingDeque<Task*> m_queue;
+    WorkerProfile m_profile;
+
+    friend class Executor;
+};
+
+// completion of one run of a task graph, valid until the graph is destroyed or run again
+class RunHandle
+{
+public:
+    RunHandle() = default;
+
+    // block until all tasks of the run are finished, a worker of the executor executes other tasks meanwhile
+    void wait() const;
+    NODISCARD bool done() const;
+
+    // co_await on the handle suspends the coroutine until the run is finished, then continues it on a worker
+    NODISCARD bool await_ready() const noexcept;
+    bool await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume() const noexcept {}
+private:
+    RunHandle(Executor* executor, TaskGraph* graph) : m_executor(executor), m_graph(graph) {}
+private:
+    Executor* m_executor = nullptr;
+    TaskGraph* m_graph = nullptr;
+
+    friend class Executor;
+};
+
+// how workers are pinned to logical cpus, a pinned worker keeps its caches warm instead of migrating
+enum class PinningPolicy : uint8_t
+{
+    e_none,         // left to the os scheduler
+    e_compact,      // worker i on cpu i, neighbouring workers share caches
+    e_scatter       // workers spread evenly over all cpus, each gets as much cache as possible
 };
 
 class Executor
 {
 public:
-    explicit Executor(size_t thread_count);
+    class ScheduleAwaiter
+    {
+    public:
+        NODISCARD bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const;
+        void await_resume() const noexcept {}
+    private:
+        explicit ScheduleAwaiter(Executor* executor) : m_executor(executor) {}
+    private:
+        Executor* m_executor;
+
+        friend class Executor;
+    };
+
+    class SleepAwaiter
+    {
+    public:
+        NODISCARD bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle) const;
+        void await_resume() const noexcept {}
+    private:
+        SleepAwaiter(Executor* executor, std::chrono::steady_clock::time_point deadline) : m_executor(executor), m_deadline(deadline) {}
+    private:
+        Executor* m_executor;
+        std::chrono::steady_clock::time_point m_deadline;
+
+        friend class Executor;
+    };
+public:
+    explicit Executor(size_t thread_count, PinningPolicy pinning = PinningPolicy::e_none, ThreadPriority priority = ThreadPriority::e_normal);
+    // worker i is pinned to cpus[i % cpus.size()], workers are not pinned with empty cpus,
+    // throw if a cpu is not below hardware concurrency
+    Executor(size_t thread_count, const Vector<uint32_t>& cpus, ThreadPriority priority = ThreadPriority::e_normal);
     ~Executor();
 
-    void run(TaskGraph& graph);
+    // start a run of graph, which finishes independently of other graphs running on this executor,
+    // throw NO_VALID_PARAMETER before starting if graph has a cycle without condition task or no start node,
+    // or if a previous run of graph is not finished yet
+    RunHandle run(TaskGraph& graph);
+    // start coroutine on a worker, it counts as a run until it returns, an exception escaping it terminates,
+    // defined in coroutine.h
+    template <typename T>
+    void spawn(Coroutine<T> coroutine);
+    // block until all runs are finished, throw NO_VALID_PARAMETER on a worker thread of this executor
     void wait();
 
+    // co_await on them continues the coroutine on a worker of this executor, at once or after the duration,
+    // no thread is blocked while it is suspended
+    NODISCARD ScheduleAwaiter schedule();
+    NODISCARD SleepAwaiter sleep_for(std::chrono::steady_clock::duration duration);
+    NODISCARD SleepAwaiter sleep_until(std::chrono::steady_clock::time_point deadline);
+
+    // write records of all workers as a chrome tracing / perfetto json file, false if it can't be written,
+    // records are read and cleared without synchronization, so no task may be running meanwhile
+    bool write_trace(const char* path) const;
+    void clear_profile();
+
+    NODISCARD size_t thread_count() const;
+    // whether calling thread is one of the workers of this executor
+    NODISCARD bool is_worker_thread() const;
+
     Executor(const Executor&) = delete;
     Executor& operator=(const Executor&) = delete;
     Executor(Executor&&) = delete;
     Executor& operator=(Executor&&) = delete;
 private:
+    // to local queue on a worker thread of this executor, otherwise to the injection queue
     void insert_task(Task* task);
-    Task* fetch_task();
+    // wake parked workers up, cheap if none of them is parked
+    void notify_one();
+    void notify_all();
+    // queue a suspended coroutine like a ready task
+    void resume(std::coroutine_handle<> handle);
+    // start tasks of a prepared graph without counting it as a run
+    void launch(TaskGraph& graph);
+    void wait(TaskGraph& graph);
+    void finish_run();
+    // resume coroutines awaiting runs which are finished
+    void resume_waiters();
+    Timer& timer();
+
+    static Vector<uint32_t> pinned_cpus(size_t thread_count, PinningPolicy pinning);
+    // nanoseconds since the executor is created
+    NODISCARD uint64_t profile_time() const;
+
+    template <typename T>
+    static Internal::DetachedCoroutine drive(Executor& executor, Coroutine<T> coroutine);
 private:
+    struct GraphWaiter
+    {
+        TaskGraph* graph;
+        std::coroutine_handle<> handle;
+    };
+
     Vector<Worker*> m_worker_pool;
-    Vector<Task*> m_task_pool;
-    std::mutex m_task_mutex;
-    uint32_t m_task_index;
+    // submissions from threads outside, pushes are serialized by the mutex while workers steal freely
+    WorkStealingDeque<Task*> m_injection_queue;
+    std::mutex m_injection_mutex;
 
+    // unfinished runs, and runs finished so far which waiters wait to change
     std::atomic<uint32_t> m_counter;
+    std::atomic<uint32_t> m_finished;
+
+    // parked workers wait for the epoch to change
+    std::atomic<uint32_t> m_epoch;
+    std::atomic<uint32_t> m_sleeping;
+
+    // coroutines awaiting runs, the count lets finishing runs skip the mutex while nobody awaits
+    Vector<GraphWaiter> m_graph_waiters;
+    std::mutex m_waiter_mutex;
+    std::atomic<uint32_t> m_waiter_count;
+
+    // started by the first sleep
+    Timer* m_timer;
+    std::mutex m_timer_mutex;
+
+    std::chrono::steady_clock::time_point m_start_time;
+    // pushes from outside which found the injection mutex locked
+    std::atomic<uint64_t> m_injection_contention;
 
     friend class Worker;
+    friend class RunHandle;
+    friend class Subflow;
+    friend class Timer;
 };
 
+// process wide executor with hardware_concurrency workers, created on first use
+Executor& default_executor();
+
 AMAZING_NAMESPACE_END
 #endif //EXECUTOR_H
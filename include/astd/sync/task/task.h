@@ -6,28 +6,166 @@
 #define TASK_H
 
 #include "astd/container/vector.h"
+#include "astd/memory/allocator.h"
 #include "astd/trait/functional.h"
 #include "astd/algorithm/iter.h"
 
 AMAZING_NAMESPACE_BEGIN
 
+class Task;
 class TaskGraph;
+class Subflow;
+class Executor;
 
+static constexpr uint32_t k_inline_edge_count = 4;
+// tasks per block of a graph, blocks grow from the minimum up to the maximum
+static constexpr uint32_t k_min_task_block_capacity = 8;
+static constexpr uint32_t k_max_task_block_capacity = 4096;
+
+INTERNAL_NAMESPACE_BEGIN
+
+// call f(subflow, args...) if f takes a subflow, otherwise f(args...)
+template <typename F, typename... Args>
+decltype(auto) invoke_task(F& f, Subflow& subflow, Args&... args)
+{
+    if constexpr (std::is_invocable_v<F&, Subflow&, Args&...>)
+        return f(subflow, args...);
+    else
+        return f(args...);
+}
+
+// a condition task returns the index of the only successor to run next
+template <typename F, typename... Args>
+static constexpr bool is_condition_task_v = [] {
+    using R = decltype(invoke_task(std::declval<F&>(), std::declval<Subflow&>(), std::declval<Args&>()...));
+    return std::is_integral_v<R> && !std::is_same_v<R, bool>;
+}();
+
+// tag of tasks which own their callable
+struct OwnedTask {};
+
+// edges of one task, the first few are kept inline, so most tasks never allocate for them
+class EdgeList
+{
+public:
+    using Iterator = Task* const*;
+
+    EdgeList() : m_data(m_inline), m_size(0), m_capacity(k_inline_edge_count) {}
+
+    ~EdgeList()
+    {
+        if (m_data != m_inline)
+            Allocator<Task*>::deallocate(m_data);
+    }
+
+    void push_back(Task* task)
+    {
+        if (m_size == m_capacity)
+            grow();
+        m_data[m_size++] = task;
+    }
+
+    void pop_back()
+    {
+        if (m_size > 0)
+            m_size--;
+    }
+
+    NODISCARD Task*& operator[](size_t index)
+    {
+        return m_data[index];
+    }
+
+    NODISCARD Task* operator[](size_t index) const
+    {
+        return m_data[index];
+    }
+
+    NODISCARD Task*& back()
+    {
+        return m_data[m_size - 1];
+    }
+
+    NODISCARD size_t size() const
+    {
+        return m_size;
+    }
+
+    NODISCARD bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    NODISCARD Iterator begin() const
+    {
+        return m_data;
+    }
+
+    NODISCARD Iterator end() const
+    {
+        return m_data + m_size;
+    }
+
+    EdgeList(const EdgeList&) = delete;
+    EdgeList& operator=(const EdgeList&) = delete;
+private:
+    void grow()
+    {
+        Task** data = Allocator<Task*>::allocate(m_capacity * 2);
+        std::memcpy(data, m_data, sizeof(Task*) * m_size);
+        if (m_data != m_inline)
+            Allocator<Task*>::deallocate(m_data);
+        m_data = data;
+        m_capacity *= 2;
+    }
+private:
+    Task** m_data;
+    uint32_t m_size;
+    uint32_t m_capacity;
+    Task* m_inline[k_inline_edge_count];
+};
+
+INTERNAL_NAMESPACE_END
+
+// a task is called as f(args...), or f(subflow, args...) to create child tasks while it runs,
+// if it returns an integer, it is a condition task which only runs the successor at that index, if any,
+// edges from a condition task don't count for join, so they can go back to form a loop
+// f and args are copied or moved into the task, pass std::ref for arguments which must be shared
 class Task
 {
 public:
-    explicit Task(Functional<void()> const& task) : m_task(task) {}
+    explicit Task(Functional<void()> const& task) : Task(Internal::OwnedTask{}, [task](Subflow&) { task(); }) {}
+    explicit Task(Functional<void(Subflow&)> const& task)
+        : m_task(task), m_join_counter(0), m_strong_count(0), m_branch(0), m_cost(1), m_priority(0), m_condition(false), m_graph(nullptr),
+          m_name(nullptr), m_ready_time(0) {}
 
+    // small captures stay in the inline storage of the task
     template <typename F, typename... Args>
-    explicit Task(F&& f, Args&&... args) : m_task([&] { f(args...); }) {}
+    explicit Task(F&& f, Args&&... args)
+        : Task(Internal::OwnedTask{}, [f = std::forward<F>(f), ...args = std::forward<Args>(args)](Subflow& subflow) -> decltype(auto)
+        {
+            return Internal::invoke_task(f, subflow, args...);
+        }) {}
+
+    // g is called as g(subflow) and kept in the task
+    template <typename G>
+    Task(Internal::OwnedTask, G&& g)
+        : m_join_counter(0), m_strong_count(0), m_branch(0), m_cost(1), m_priority(0), m_condition(Internal::is_condition_task_v<std::decay_t<G> const>),
+          m_graph(nullptr), m_name(nullptr), m_ready_time(0)
+    {
+        if constexpr (Internal::is_condition_task_v<std::decay_t<G> const>)
+            m_task = [g = std::forward<G>(g), this](Subflow& subflow) { m_branch = static_cast<uint32_t>(g(subflow)); };
+        else
+            m_task = [g = std::forward<G>(g)](Subflow& subflow) { g(subflow); };
+    }
 
     ~Task() = default;
 
     template <typename... Ts>
     Task& precede(Ts&&... tasks)
     {
-        (m_precede_nodes.push_back(std::forward<Ts>(tasks)), ...);
-        (tasks->m_succeed_nodes.push_back(this), ...);
+        (link(tasks), ...);
+        invalidate();
         return *this;
     }
 
@@ -38,9 +176,9 @@ public:
         return *this;
     }
 
-    void operator()()
+    void operator()(Subflow& subflow)
     {
-        m_task();
+        m_task(subflow);
     }
 
     NODISCARD explicit operator bool() const
@@ -48,17 +186,88 @@ public:
         return static_cast<bool>(m_task);
     }
 
+    NODISCARD bool is_condition() const
+    {
+        return m_condition;
+    }
+
+    // relative cost hint, tasks on the longest path weighted by costs are preferred when several are ready
+    Task& set_cost(uint32_t cost)
+    {
+        m_cost = cost;
+        invalidate();
+        return *this;
+    }
+
+    NODISCARD uint32_t cost() const
+    {
+        return m_cost;
+    }
+
+    // cost of the longest path from this task to the end of its graph, valid after the graph is run
+    NODISCARD uint64_t priority() const
+    {
+        return m_priority;
+    }
+
+    // shown in executor profiles, name must outlive the task, such as a literal
+    Task& set_name(const char* name)
+    {
+        m_name = name;
+        return *this;
+    }
+
+    NODISCARD const char* name() const
+    {
+        return m_name;
+    }
+
+private:
+    // add an edge, task runs before this one
+    void link(Task* task);
+    // let the graph compile again before its next run
+    void invalidate();
 private:
-    Functional<void()> m_task;
-    Vector<Task*> m_precede_nodes;
-    Vector<Task*> m_succeed_nodes;
+    Functional<void(Subflow&)> m_task;
+    Internal::EdgeList m_precede_nodes;
+    Internal::EdgeList m_succeed_nodes;
     std::atomic<uint32_t> m_join_counter;
+    // predecessors which are not condition tasks, the join counter starts from it
+    uint32_t m_strong_count;
+    // successor chosen by the latest call of a condition task
+    uint32_t m_branch;
+    uint32_t m_cost;
+    uint64_t m_priority;
+    bool m_condition;
+    TaskGraph* m_graph;
+    const char* m_name;
+    // when the task became ready, only recorded for profiles
+    uint64_t m_ready_time;
 
     friend class TaskGraph;
     friend class Worker;
+    friend class Executor;
+    friend class Subflow;
 };
 
 
+// what finishing the last task of a graph does
+enum class GraphCompletion : uint8_t
+{
+    // finish a run started by Executor::run
+    e_run,
+    // subflow joined at the end of its parent task, release successors of the parent
+    e_join,
+    // subflow detached from its parent task, only the run of the parent waits for it
+    e_detach,
+    // subflow joined inside the body of its parent task, which waits for it
+    e_wait,
+};
+
+// nodes live in blocks owned by the graph, and edges beyond the inline ones are allocated from the memory pool,
+// never from a MonotonicArena, so a graph may outlive any arena it is built or extended in
+// a graph can be run again once its last run is finished, join counters are reset in place for every run,
+// different graphs may run on one executor at the same time
 class TaskGraph
 {
 public:
@@ -68,23 +277,89 @@ public:
     template <typename F, typename... Args>
     Task* emplace(F&& f, Args&&... args)
     {
-        Task* task = PLACEMENT_NEW(Task, sizeof(Task), std::forward<F>(f), std::forward<Args>(args)...);
+        Task* task = new (allocate_task()) Task(std::forward<F>(f), std::forward<Args>(args)...);
+        task->m_graph = this;
         m_task_nodes.push_back(task);
         m_task_counter++;
+        m_compiled = false;
         return task;
     }
 
     void erase(Task* task);
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
 private:
-    // reorder task nodes based on their dependencies
-    // after compile, all no dependency node will be moved to the front of the task graph
+    // header of a block of task slots, slots follow it
+    struct TaskBlock
+    {
+        TaskBlock* prev;
+        uint32_t capacity;
+        uint32_t size;
+    };
+
+    // slot of an erased task if there is one, otherwise the next slot of the latest block
+    Task* allocate_task();
+    void add_task_block(uint32_t capacity);
+
+    // reset join counters for a new run, compile only if nodes, edges or costs changed since last run,
+    // throw NO_VALID_PARAMETER if the graph has a cycle without condition task or no start node
+    void prepare();
+    // compute priorities of task nodes and reorder them based on their dependencies
+    // after compile, all no dependency node will be moved to the front of the task graph, higher priority first
     void compile();
 private:
     Vector<Task*> m_task_nodes;
+    TaskBlock* m_task_block;
+    // erased slots, linked by their first word
+    Task* m_free_task;
     uint32_t m_task_counter;
     uint32_t m_join_counter;
+    bool m_compiled;
+    // unfinished tasks of the current run
+    std::atomic<uint32_t> m_pending;
+    GraphCompletion m_completion;
+    // task which creates this graph as its subflow
+    Task* m_parent;
 
+    friend class Task;
     friend class Executor;
+    friend class Worker;
+    friend class RunHandle;
+    friend class Subflow;
+};
+
+
+// child tasks created by a running task, scheduled on the same executor,
+// they are joined at the end of the parent task unless join or detach is called before
+class Subflow
+{
+public:
+    // children run after the body of their parent returns, so they keep copies of f and args
+    template <typename F, typename... Args>
+    Task* emplace(F&& f, Args&&... args)
+    {
+        return graph().emplace(std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // run the children created so far and wait for them, new children can be created afterwards
+    void join();
+    // let the children created so far run on their own, successors of the parent task don't wait for them,
+    // but the run of the parent does
+    void detach();
+
+    Subflow(const Subflow&) = delete;
+    Subflow& operator=(const Subflow&) = delete;
+private:
+    Subflow(Executor* executor, Task* parent) : m_executor(executor), m_parent(parent), m_graph(nullptr) {}
+
+    TaskGraph& graph();
+private:
+    Executor* m_executor;
+    Task* m_parent;
+    TaskGraph* m_graph;
+
+    friend class Worker;
 };
 
 AMAZING_NAMESPACE_END
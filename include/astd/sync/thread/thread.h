@@ -7,9 +7,21 @@
 
 #include <thread>
 #include "astd/base/macro.h"
+#include "astd/container/string.h"
+#include "astd/container/vector.h"
 
 AMAZING_NAMESPACE_BEGIN
 
+// mapped to nice values on linux and thread priorities on windows, raising it may need privileges
+enum class ThreadPriority : uint8_t
+{
+    e_lowest,
+    e_low,
+    e_normal,
+    e_high,
+    e_highest
+};
+
 class Thread
 {
 public:
@@ -19,17 +31,33 @@ public:
     void start();
     void stop();
 
+    // attributes are applied by the thread itself when it starts, a failure is logged and the thread runs anyway
+    // name is truncated to 15 characters on linux
+    void set_name(const char* name);
+    // logical cpus the thread may run on, empty leaves it free to run anywhere,
+    // on windows they must be in one processor group
+    void set_affinity(const Vector<uint32_t>& cpus);
+    void set_priority(ThreadPriority priority);
+
     NODISCARD bool is_running() const;
     NODISCARD uint32_t id() const;
+    NODISCARD const String& name() const;
+    NODISCARD const Vector<uint32_t>& affinity() const;
+    NODISCARD ThreadPriority priority() const;
 
     Thread(Thread&&) = default;
     Thread& operator=(Thread&&) = default;
 protected:
     virtual void run(std::stop_token) = 0;
 
+private:
+    void apply_attributes() const;
 private:
     std::jthread m_thread;
     bool m_running;
+    String m_name;
+    Vector<uint32_t> m_affinity;
+    ThreadPriority m_priority;
 };
 
 
@@ -1,14 +1,61 @@
 #include <cstring>
+#include <cstdlib>
+#include <bit>
+#include <atomic>
+#include <mutex>
+#include <initializer_list>
 #include <astd/base/util.h>
 #include <astd/base/except.h>
 #include <astd/memory/allocator.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
 AMAZING_NAMESPACE_BEGIN
 
+// address space is reserved up front, physical pages are committed when first used
+constexpr static size_t k_commit_granularity = 64 * 1024;
+
+static void* reserve_memory(size_t size)
+{
+#ifdef _WIN32
+    return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* p = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+static bool commit_memory(void* p, size_t size)
+{
+#ifdef _WIN32
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void release_memory(void* p, size_t size)
+{
+#ifdef _WIN32
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
+}
+
+
+class IMemoryPool;
+class MemoryArena;
 
 struct MemoryHeaderInfo
 {
-    size_t position;
+    size_t position;    // relative to arena memory
     size_t size;        // exclude header
     size_t offset;      // available memory offset
 
@@ -16,91 +63,409 @@ struct MemoryHeaderInfo
     MemoryHeaderInfo* prev;
 
     void* data;         // for user data
+    MemoryArena* arena; // arena the block is allocated from
+    bool binned;        // waiting in a bin, may be absorbed by the block before it
 };
 
-constexpr static size_t k_memory_header_size = align_to(sizeof(MemoryHeaderInfo), k_cache_alignment);
+constexpr static size_t k_memory_header_size = align_to(sizeof(MemoryHeaderInfo), k_min_alignment);
 
+// size classes for small blocks, power of two from 16 B to 4 KB
+constexpr static size_t k_min_bin_size = 16;
+constexpr static size_t k_max_bin_size = 4096;
+constexpr static size_t k_bin_count = std::countr_zero(k_max_bin_size) - std::countr_zero(k_min_bin_size) + 1;
 
-class IMemoryPool
+static size_t bin_index(size_t size)
+{
+    return std::bit_width(std::max(size, k_min_bin_size) - 1) - std::countr_zero(k_min_bin_size);
+}
+
+static size_t bin_size(size_t index)
+{
+    return k_min_bin_size << index;
+}
+
+static bool is_aligned(const void* p, size_t alignment)
+{
+    return (reinterpret_cast<uintptr_t>(p) & (alignment - 1)) == 0;
+}
+
+static MemoryHeaderInfo* header_of(void* p)
+{
+    return reinterpret_cast<MemoryHeaderInfo*>(static_cast<uint8_t*>(p) - k_memory_header_size);
+}
+
+
+// a reserved range of address space placed right before its own memory,
+// blocks inside are linked by a circular header list
+class MemoryArena
 {
 public:
-    explicit IMemoryPool(size_t size = k_local_memory_size);
-    ~IMemoryPool();
+    // dedicated arena holds a single huge block and is released with it
+    static MemoryArena* create(IMemoryPool* owner, size_t size, bool dedicated);
+    static void destroy(MemoryArena* arena);
 
+    // nullptr if there is no position large enough
     void* allocate(size_t size, size_t alignment, void* data);
-    void* reallocate(void* p, size_t size, size_t alignment, void* data);
-    void deallocate(void* p);
+    // grow or shrink in place, false if the block can't hold size
+    bool reallocate(MemoryHeaderInfo* header, size_t size);
+    void deallocate(MemoryHeaderInfo* header);
+
+    void acquire_block() { m_block_count++; }
+    void release_block() { m_block_count--; }
+
+    NODISCARD IMemoryPool* owner() const { return m_owner; }
+    NODISCARD bool dedicated() const { return m_dedicated; }
+    NODISCARD bool empty() const { return m_block_count == 0; }
+private:
+    MemoryArena(IMemoryPool* owner, size_t size, bool dedicated);
+
+    // make sure memory before position is committed
+    void commit(size_t position);
 private:
     uint8_t* m_data;
     size_t m_size;
+    size_t m_committed;
+    size_t m_block_count;   // blocks held by caller, binned ones excluded
     MemoryHeaderInfo* m_current_info;
+    IMemoryPool* m_owner;
+    MemoryArena* m_next;
+    bool m_dedicated;
+
+    friend class IMemoryPool;
 };
 
-IMemoryPool::IMemoryPool(size_t size) : m_current_info(nullptr)
+constexpr static size_t k_memory_arena_header_size = align_to(sizeof(MemoryArena), k_cache_alignment);
+
+MemoryArena::MemoryArena(IMemoryPool* owner, size_t size, bool dedicated) :
+    m_size(size), m_committed(k_commit_granularity), m_block_count(0), m_current_info(nullptr),
+    m_owner(owner), m_next(nullptr), m_dedicated(dedicated)
+{
+    m_data = reinterpret_cast<uint8_t*>(this) + k_memory_arena_header_size;
+}
+
+MemoryArena* MemoryArena::create(IMemoryPool* owner, size_t size, bool dedicated)
 {
-    m_data = new uint8_t[size];
-    if (!m_data)
+    size_t reserve_size = align_to(k_memory_arena_header_size + size, k_commit_granularity);
+
+    // fresh pages are zeroed by the system
+    void* memory = reserve_memory(reserve_size);
+    if (!memory)
         throw AStdException(AStdError::NO_ENOUGH_MEMORY);
-    std::memset(m_data, 0, size);
-    m_size = size;
+    if (!commit_memory(memory, k_commit_granularity))
+    {
+        release_memory(memory, reserve_size);
+        throw AStdException(AStdError::NO_ENOUGH_MEMORY);
+    }
+
+    return new (memory) MemoryArena(owner, reserve_size - k_memory_arena_header_size, dedicated);
 }
 
-IMemoryPool::~IMemoryPool()
+void MemoryArena::destroy(MemoryArena* arena)
 {
-    delete[] m_data;
-    m_data = nullptr;
+    release_memory(arena, k_memory_arena_header_size + arena->m_size);
 }
 
-void* IMemoryPool::allocate(size_t size, size_t alignment, void* data)
+void MemoryArena::commit(size_t position)
 {
-    if (size == 0)
-        return nullptr;
+    size_t end = k_memory_arena_header_size + position;
+    if (end <= m_committed)
+        return;
 
-    size_t align_size = align_to(size, alignment);
-    if (m_current_info)
+    size_t committed = std::min(align_to(end, k_commit_granularity), k_memory_arena_header_size + m_size);
+    if (!commit_memory(reinterpret_cast<uint8_t*>(this) + m_committed, committed - m_committed))
+        throw AStdException(AStdError::NO_ENOUGH_MEMORY);
+    m_committed = committed;
+}
+
+void* MemoryArena::allocate(size_t size, size_t alignment, void* data)
+{
+    if (m_current_info == nullptr)
     {
-        MemoryHeaderInfo* iterator = m_current_info;
-        do
+        // the block at position 0 anchors the list, it is left empty until memory right behind it suits a request
+        commit(k_memory_header_size);
+        m_current_info = new (m_data) MemoryHeaderInfo;
+        m_current_info->prev = m_current_info;
+        m_current_info->next = m_current_info;
+        m_current_info->offset = 0;
+        m_current_info->position = 0;
+        m_current_info->size = m_size - k_memory_header_size;
+        m_current_info->data = nullptr;
+        m_current_info->arena = this;
+        m_current_info->binned = false;
+    }
+
+    MemoryHeaderInfo* iterator = m_current_info;
+    do
+    {
+        uint8_t* memory = reinterpret_cast<uint8_t*>(iterator) + k_memory_header_size;
+        size_t end = iterator->position + k_memory_header_size + iterator->size;
+
+        // an empty anchor takes the request itself
+        if (iterator->offset == 0 && !iterator->binned && is_aligned(memory, alignment) && size <= iterator->size)
         {
-            if (iterator->offset + align_size + k_memory_header_size <= iterator->size)
-            {
-                MemoryHeaderInfo* header = new (m_data + iterator->position + k_memory_header_size + iterator->offset) MemoryHeaderInfo;
-                header->prev = iterator;
-                header->next = iterator->next;
-                header->size = iterator->size - iterator->offset - k_memory_header_size;
-                header->offset = align_size;
-                header->position = iterator->position + k_memory_header_size + iterator->offset;
-                header->data = data;
+            commit(iterator->position + k_memory_header_size + size);
+            iterator->offset = size;
+            iterator->data = data;
+            m_current_info = iterator;
+            m_block_count++;
+            return memory;
+        }
+
+        // split a new block from the gap behind used memory, padding goes to the gap's owner
+        uintptr_t payload = align_to(reinterpret_cast<uintptr_t>(memory) + iterator->offset + k_memory_header_size, static_cast<uintptr_t>(alignment));
+        size_t position = payload - reinterpret_cast<uintptr_t>(m_data) - k_memory_header_size;
+        if (position + k_memory_header_size + size <= end)
+        {
+            commit(position + k_memory_header_size + size);
+            MemoryHeaderInfo* header = new (m_data + position) MemoryHeaderInfo;
+            header->prev = iterator;
+            header->next = iterator->next;
+            header->size = end - position - k_memory_header_size;
+            header->offset = size;
+            header->position = position;
+            header->data = data;
+            header->arena = this;
+            header->binned = false;
+
+            iterator->size = position - iterator->position - k_memory_header_size;
+            iterator->next->prev = header;
+            iterator->next = header;
+
+            m_current_info = header;
+            m_block_count++;
+            return reinterpret_cast<void*>(payload);
+        }
+        iterator = iterator->next;
+    } while (iterator != m_current_info);
+
+    return nullptr;
+}
 
-                iterator->size = iterator->offset;
-                iterator->next->prev = header;
-                iterator->next = header;
+bool MemoryArena::reallocate(MemoryHeaderInfo* header, size_t size)
+{
+    if (size > header->size)
+        return false;
 
-                m_current_info = header;
+    // keep the released tail zeroed as the rest of free memory
+    uint8_t* p = reinterpret_cast<uint8_t*>(header) + k_memory_header_size;
+    if (size < header->offset)
+        std::memset(p + size, 0, header->offset - size);
+    else
+        commit(header->position + k_memory_header_size + size);
+    header->offset = size;
+    return true;
+}
 
-                break;
-            }
-            iterator = iterator->next;
-        } while (iterator != m_current_info);
+void MemoryArena::deallocate(MemoryHeaderInfo* header)
+{
+    if (header->position != 0)
+    {
+        MemoryHeaderInfo* prev = header->prev;
+        prev->size = prev->size + k_memory_header_size + header->size;
+        prev->next = header->next;
 
-        if (m_current_info == iterator)
-            throw AStdException(AStdError::NO_APPLICABLE_POSITION);
+        header->next->prev = prev;
+        if (m_current_info == header)
+            m_current_info = prev;
+        std::memset(header, 0, k_memory_header_size + header->offset);
     }
     else
     {
-        if (m_size < align_size + k_memory_header_size)
-            throw AStdException(AStdError::NO_ENOUGH_MEMORY);
+        std::memset(reinterpret_cast<uint8_t*>(header) + k_memory_header_size, 0, header->offset);
+        header->offset = 0;
+    }
+}
 
-        m_current_info = new (m_data) MemoryHeaderInfo;
-        m_current_info->prev = m_current_info;
-        m_current_info->next = m_current_info;
-        m_current_info->offset = align_size;
-        m_current_info->position = 0;
-        m_current_info->size = m_size - k_memory_header_size;
-        m_current_info->data = data;
+
+// written by the owner thread only, others may read them at any time
+class MemoryCounters
+{
+public:
+    void allocated(MAYBE_UNUSED size_t size)
+    {
+#ifdef ASTD_MEMORY_STATISTICS
+        add(m_allocate_count, 1);
+        grow(size);
+#endif
+    }
+
+    void reallocated(MAYBE_UNUSED size_t old_size, MAYBE_UNUSED size_t size)
+    {
+#ifdef ASTD_MEMORY_STATISTICS
+        add(m_reallocate_count, 1);
+        m_bytes_in_use.store(m_bytes_in_use.load(std::memory_order_relaxed) - old_size, std::memory_order_relaxed);
+        grow(size);
+#endif
+    }
+
+    void deallocated(MAYBE_UNUSED size_t size)
+    {
+#ifdef ASTD_MEMORY_STATISTICS
+        add(m_deallocate_count, 1);
+        m_bytes_in_use.store(m_bytes_in_use.load(std::memory_order_relaxed) - size, std::memory_order_relaxed);
+#endif
+    }
+
+    void collect(MemoryStatistics& statistics) const
+    {
+        statistics.bytes_in_use += m_bytes_in_use.load(std::memory_order_relaxed);
+        statistics.peak_bytes_in_use += m_peak_bytes_in_use.load(std::memory_order_relaxed);
+        statistics.allocate_count += m_allocate_count.load(std::memory_order_relaxed);
+        statistics.reallocate_count += m_reallocate_count.load(std::memory_order_relaxed);
+        statistics.deallocate_count += m_deallocate_count.load(std::memory_order_relaxed);
+    }
+private:
+    // single writer, no need for read modify write
+    static void add(std::atomic<size_t>& counter, size_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void grow(size_t size)
+    {
+        add(m_bytes_in_use, size);
+        size_t bytes_in_use = m_bytes_in_use.load(std::memory_order_relaxed);
+        if (bytes_in_use > m_peak_bytes_in_use.load(std::memory_order_relaxed))
+            m_peak_bytes_in_use.store(bytes_in_use, std::memory_order_relaxed);
+    }
+private:
+    std::atomic<size_t> m_bytes_in_use{0};
+    std::atomic<size_t> m_peak_bytes_in_use{0};
+    std::atomic<size_t> m_allocate_count{0};
+    std::atomic<size_t> m_reallocate_count{0};
+    std::atomic<size_t> m_deallocate_count{0};
+};
+
+
+class IMemoryPool
+{
+public:
+    explicit IMemoryPool(size_t arena_size = k_local_memory_size);
+    ~IMemoryPool();
+
+    void* allocate(size_t size, size_t alignment, void* data);
+    void* reallocate(void* p, size_t size, size_t alignment, void* data);
+    void deallocate(void* p);
+
+    // called by threads other than owner, the block is returned on the owner's next allocation,
+    // or right away by MemoryPoolRegistry if the pool is abandoned
+    void remote_deallocate(void* p);
+    void drain_remote();
+
+    static IMemoryPool* owner(void* p);
+
+    // counters, and walk arenas for their layout if layout is true, only safe when no other thread uses the pool
+    void collect(MemoryStatistics& statistics, bool layout) const;
+private:
+    void* allocate_block(size_t size, size_t alignment, void* data);
+
+    // nullptr if the bin is empty, or its first block is not aligned
+    void* pop_bin(size_t index, size_t size, size_t alignment, void* data);
+    void push_bin(MemoryHeaderInfo* header);
+    void unlink_bin(MemoryHeaderInfo* header);
+    // merge binned blocks right behind header into it until it can hold size
+    bool absorb(MemoryHeaderInfo* header, size_t size);
+
+    void* allocate_dedicated(size_t size, size_t alignment, void* data);
+    // keep one empty arena around, so a working set at the boundary doesn't map and unmap repeatedly
+    void retire_arena(MemoryArena* arena);
+    void release_arena(MemoryArena* arena);
+private:
+    size_t m_arena_size;
+    // the first arena is never released
+    MemoryArena* m_arenas;
+    MemoryArena* m_current_arena;
+    MemoryArena* m_empty_arena;
+    MemoryArena* m_dedicated_arenas;
+
+    // freed small blocks stay in the header list, the first two words of their memory link the next and previous one
+    void* m_bins[k_bin_count];
+
+    // lock free stack of blocks freed by other threads, linked the same way as bins
+    std::atomic<void*> m_remote_free;
+
+    // link of abandoned pools waiting for a new thread to adopt them
+    IMemoryPool* m_next_abandoned;
+    // link of all thread pools, they are never destroyed
+    IMemoryPool* m_next_registered;
+    // only changed under the registry lock, read without it by threads freeing into the pool
+    std::atomic<bool> m_abandoned;
+
+    MemoryCounters m_counters;
+
+    friend class MemoryPoolRegistry;
+};
+
+IMemoryPool::IMemoryPool(size_t arena_size) : m_arena_size(arena_size), m_empty_arena(nullptr), m_dedicated_arenas(nullptr), m_bins{}, m_remote_free(nullptr), m_next_abandoned(nullptr), m_next_registered(nullptr), m_abandoned(false)
+{
+    m_arenas = MemoryArena::create(this, m_arena_size, false);
+    m_current_arena = m_arenas;
+}
+
+IMemoryPool::~IMemoryPool()
+{
+    for (MemoryArena* arenas : { m_arenas, m_dedicated_arenas })
+    {
+        while (arenas)
+        {
+            MemoryArena* next = arenas->m_next;
+            MemoryArena::destroy(arenas);
+            arenas = next;
+        }
+    }
+}
+
+void* IMemoryPool::allocate(size_t size, size_t alignment, void* data)
+{
+    void* p = allocate_block(size, alignment, data);
+    if (p)
+        m_counters.allocated(header_of(p)->offset);
+    return p;
+}
+
+void* IMemoryPool::allocate_block(size_t size, size_t alignment, void* data)
+{
+    if (size == 0)
+        return nullptr;
+
+    if (m_remote_free.load(std::memory_order_relaxed))
+        drain_remote();
+
+    // sizes are kept in units of minimum alignment, placement takes care of larger alignments
+    alignment = std::max(alignment, k_min_alignment);
+    size_t align_size = align_to(size, k_min_alignment);
+    if (align_size <= k_max_bin_size)
+    {
+        size_t index = bin_index(align_size);
+        if (void* p = pop_bin(index, align_size, alignment, data))
+            return p;
+
+        // reserve the whole size class, so the block can be binned when freed
+        align_size = std::max(align_size, bin_size(index));
     }
+    else if (align_size >= m_arena_size / 8)
+        return allocate_dedicated(align_size, alignment, data);
 
-    return m_data + m_current_info->position + k_memory_header_size;
+    MemoryArena* arena = m_current_arena;
+    do
+    {
+        if (void* p = arena->allocate(align_size, alignment, data))
+        {
+            m_current_arena = arena;
+            if (m_empty_arena == arena)
+                m_empty_arena = nullptr;
+            return p;
+        }
+        arena = arena->m_next ? arena->m_next : m_arenas;
+    } while (arena != m_current_arena);
+
+    // all arenas are full, chain a new one behind the first
+    arena = MemoryArena::create(this, m_arena_size, false);
+    arena->m_next = m_arenas->m_next;
+    m_arenas->m_next = arena;
+    m_current_arena = arena;
+
+    return arena->allocate(align_size, alignment, data);
 }
 
 void* IMemoryPool::reallocate(void* p, size_t size, size_t alignment, void* data)
@@ -108,22 +473,21 @@ void* IMemoryPool::reallocate(void* p, size_t size, size_t alignment, void* data
     if (p == nullptr)
         return allocate(size, alignment, data);
 
-    MemoryHeaderInfo* header = reinterpret_cast<MemoryHeaderInfo*>(reinterpret_cast<uint8_t*>(p) - k_memory_header_size);
-    if (size <= header->size)
+    MemoryHeaderInfo* header = header_of(p);
+    size_t old_size = header->offset;
+    size_t align_size = align_to(size, k_min_alignment);
+    if ((align_size <= header->size || absorb(header, align_size)) && header->arena->reallocate(header, align_size))
     {
-        header->offset = align_to(size, alignment);
         header->data = data;
+        m_counters.reallocated(old_size, header->offset);
         return p;
     }
 
-    // free and find appropriate position
-    MemoryHeaderInfo* prev = header->prev;
-    prev->size = prev->size + k_memory_header_size + header->size;
-    prev->next = header->next;
-
-    header->next->prev = prev;
-
-    return allocate(size, alignment, data);
+    // the old block is still owned by caller, who copies the content and deallocates it
+    void* new_p = allocate_block(size, alignment, data);
+    if (new_p)
+        m_counters.reallocated(0, header_of(new_p)->offset);
+    return new_p;
 }
 
 void IMemoryPool::deallocate(void* p)
@@ -131,27 +495,361 @@ void IMemoryPool::deallocate(void* p)
     if (p == nullptr)
         return;
 
-    MemoryHeaderInfo* header = reinterpret_cast<MemoryHeaderInfo*>(reinterpret_cast<uint8_t*>(p) - k_memory_header_size);
-    if (header->position != 0)
+    MemoryHeaderInfo* header = header_of(p);
+    m_counters.deallocated(header->offset);
+
+    MemoryArena* arena = header->arena;
+    if (arena->dedicated())
     {
-        MemoryHeaderInfo* prev = header->prev;
-        prev->size = prev->size + k_memory_header_size + header->size;
-        prev->next = header->next;
+        MemoryArena** link = &m_dedicated_arenas;
+        while (*link != arena)
+            link = &(*link)->m_next;
+        *link = arena->m_next;
 
-        header->next->prev = prev;
-        if (m_current_info == header)
-            m_current_info = prev;
-        std::memset(header, 0, k_memory_header_size + header->offset);
+        MemoryArena::destroy(arena);
+        return;
     }
+
+    if (header->offset <= k_max_bin_size)
+        push_bin(header);
     else
-        header->offset = 0;
+        arena->deallocate(header);
+
+    arena->release_block();
+    if (arena->empty() && arena != m_arenas)
+        retire_arena(arena);
+}
+
+void* IMemoryPool::pop_bin(size_t index, size_t size, size_t alignment, void* data)
+{
+    void* p = m_bins[index];
+    if (p == nullptr || !is_aligned(p, alignment))
+        return nullptr;
+
+    MemoryHeaderInfo* header = header_of(p);
+    unlink_bin(header);
+    header->offset = size;
+    header->data = data;
+
+    header->arena->acquire_block();
+    if (m_empty_arena == header->arena)
+        m_empty_arena = nullptr;
+
+    return p;
+}
+
+void IMemoryPool::push_bin(MemoryHeaderInfo* header)
+{
+    void** p = reinterpret_cast<void**>(reinterpret_cast<uint8_t*>(header) + k_memory_header_size);
+    std::memset(p, 0, header->offset);
+
+    // the block keeps its whole size class reserved while it waits in the bin
+    size_t index = bin_index(header->offset);
+    if (bin_size(index) > header->size)
+        index--;
+    header->offset = bin_size(index);
+    header->data = nullptr;
+    header->binned = true;
+
+    p[0] = m_bins[index];
+    if (m_bins[index])
+        static_cast<void**>(m_bins[index])[1] = p;
+    m_bins[index] = p;
+}
+
+void IMemoryPool::unlink_bin(MemoryHeaderInfo* header)
+{
+    void** p = reinterpret_cast<void**>(reinterpret_cast<uint8_t*>(header) + k_memory_header_size);
+    void* next = p[0];
+    void* prev = p[1];
+    if (prev)
+        static_cast<void**>(prev)[0] = next;
+    else
+        m_bins[bin_index(header->offset)] = next;
+    if (next)
+        static_cast<void**>(next)[1] = prev;
+
+    p[0] = nullptr;
+    p[1] = nullptr;
+    header->binned = false;
+}
+
+bool IMemoryPool::absorb(MemoryHeaderInfo* header, size_t size)
+{
+    if (header->arena->dedicated())
+        return false;
+
+    // the list is sorted by position, the block at position 0 is where it wraps
+    size_t capacity = header->size;
+    MemoryHeaderInfo* end = header->next;
+    while (capacity < size && end->binned && end->position != 0)
+    {
+        capacity += k_memory_header_size + end->size;
+        end = end->next;
+    }
+    if (capacity < size)
+        return false;
+
+    MemoryArena* arena = header->arena;
+    while (header->next != end)
+    {
+        MemoryHeaderInfo* next = header->next;
+        unlink_bin(next);
+
+        header->size += k_memory_header_size + next->size;
+        header->next = next->next;
+        next->next->prev = header;
+        if (arena->m_current_info == next)
+            arena->m_current_info = header;
+        std::memset(next, 0, k_memory_header_size + next->offset);
+    }
+    return true;
+}
+
+void* IMemoryPool::allocate_dedicated(size_t size, size_t alignment, void* data)
+{
+    // reserve twice the address space, so the block can grow in place, pages are only committed when used
+    MemoryArena* arena = MemoryArena::create(this, 2 * k_memory_header_size + alignment + size * 2, true);
+    arena->m_next = m_dedicated_arenas;
+    m_dedicated_arenas = arena;
+    return arena->allocate(size, alignment, data);
+}
+
+void IMemoryPool::retire_arena(MemoryArena* arena)
+{
+    if (m_empty_arena && m_empty_arena != arena)
+        release_arena(m_empty_arena);
+    m_empty_arena = arena;
+}
+
+void IMemoryPool::release_arena(MemoryArena* arena)
+{
+    // binned blocks are the only ones left in an empty arena
+    for (void* p : m_bins)
+    {
+        while (p)
+        {
+            void* next = *static_cast<void**>(p);
+            if (header_of(p)->arena == arena)
+                unlink_bin(header_of(p));
+            p = next;
+        }
+    }
+
+    MemoryArena* prev = m_arenas;
+    while (prev->m_next != arena)
+        prev = prev->m_next;
+    prev->m_next = arena->m_next;
+
+    if (m_current_arena == arena)
+        m_current_arena = m_arenas;
+
+    MemoryArena::destroy(arena);
+}
+
+void IMemoryPool::remote_deallocate(void* p)
+{
+    void* head = m_remote_free.load(std::memory_order_relaxed);
+    do
+    {
+        *static_cast<void**>(p) = head;
+    } while (!m_remote_free.compare_exchange_weak(head, p, std::memory_order_seq_cst, std::memory_order_relaxed));
+}
+
+void IMemoryPool::drain_remote()
+{
+    void* p = m_remote_free.exchange(nullptr, std::memory_order_seq_cst);
+    while (p)
+    {
+        void* next = *static_cast<void**>(p);
+        deallocate(p);
+        p = next;
+    }
+}
+
+IMemoryPool* IMemoryPool::owner(void* p)
+{
+    return header_of(p)->arena->owner();
+}
+
+void IMemoryPool::collect(MemoryStatistics& statistics, bool layout) const
+{
+    m_counters.collect(statistics);
+    if (!layout)
+        return;
+
+    for (MemoryArena* arena = m_arenas; arena; arena = arena->m_next)
+    {
+        statistics.bytes_reserved += k_memory_arena_header_size + arena->m_size;
+        statistics.bytes_committed += arena->m_committed;
+
+        MemoryHeaderInfo* header = arena->m_current_info;
+        if (header == nullptr)
+        {
+            statistics.free_block_count++;
+            statistics.largest_free_block = std::max(statistics.largest_free_block, arena->m_size - k_memory_header_size);
+            continue;
+        }
+
+        do
+        {
+            // a binned block is free as a whole, otherwise a new block may be split from the gap behind its memory
+            size_t free_size = 0;
+            if (header->binned)
+                free_size = header->size;
+            else if (header->size >= header->offset + k_memory_header_size)
+                free_size = header->size - header->offset - k_memory_header_size;
+
+            if (free_size > 0)
+            {
+                statistics.free_block_count++;
+                statistics.largest_free_block = std::max(statistics.largest_free_block, free_size);
+            }
+            header = header->next;
+        } while (header != arena->m_current_info);
+    }
+
+    // the growth room of dedicated arenas serves no other block
+    for (MemoryArena* arena = m_dedicated_arenas; arena; arena = arena->m_next)
+    {
+        statistics.bytes_reserved += k_memory_arena_header_size + arena->m_size;
+        statistics.bytes_committed += arena->m_committed;
+    }
 }
 
+
+// smaller arenas would send ordinary blocks to dedicated arenas
+constexpr static size_t k_min_local_memory_size = 1024 * 1024;
+
+static std::atomic<size_t> s_local_memory_size = 0;
+
+static size_t environment_memory_size()
+{
+    const char* value = std::getenv("ASTD_LOCAL_MEMORY_SIZE");
+    if (value == nullptr)
+        return k_local_memory_size;
+
+    char* end = nullptr;
+    size_t size = std::strtoull(value, &end, 10);
+    switch (*end)
+    {
+    case 'G': case 'g':
+        size <<= 10;
+        [[fallthrough]];
+    case 'M': case 'm':
+        size <<= 10;
+        [[fallthrough]];
+    case 'K': case 'k':
+        size <<= 10;
+        break;
+    default:
+        break;
+    }
+
+    return size == 0 ? k_local_memory_size : std::max(size, k_min_local_memory_size);
+}
+
+void set_local_memory_size(size_t size)
+{
+    s_local_memory_size.store(std::max(size, k_min_local_memory_size), std::memory_order_relaxed);
+}
+
+size_t local_memory_size()
+{
+    size_t size = s_local_memory_size.load(std::memory_order_relaxed);
+    if (size == 0)
+    {
+        // a value set meanwhile wins over the environment
+        size_t expected = 0;
+        s_local_memory_size.compare_exchange_strong(expected, environment_memory_size(), std::memory_order_relaxed);
+        size = s_local_memory_size.load(std::memory_order_relaxed);
+    }
+    return size;
+}
+
+
+// pools outlive their threads, since blocks may still be referenced by others,
+// an exiting thread abandons its pool and the next new thread adopts it
+class MemoryPoolRegistry
+{
+public:
+    static IMemoryPool* acquire()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (IMemoryPool* pool = s_abandoned)
+        {
+            s_abandoned = pool->m_next_abandoned;
+            pool->m_next_abandoned = nullptr;
+            pool->m_abandoned.store(false, std::memory_order_relaxed);
+            return pool;
+        }
+
+        IMemoryPool* pool = new IMemoryPool(local_memory_size());
+        pool->m_next_registered = s_pools;
+        s_pools = pool;
+        return pool;
+    }
+
+    static void release(IMemoryPool* pool)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        pool->m_next_abandoned = s_abandoned;
+        pool->m_abandoned.store(true, std::memory_order_seq_cst);
+        s_abandoned = pool;
+        pool->drain_remote();
+    }
+
+    // blocks freed into an abandoned pool are merged under the lock, so they are reusable before the pool is adopted,
+    // release drains after marking the pool, so either it finds the block or the block finds the mark
+    static void remote_deallocate(IMemoryPool* pool, void* p)
+    {
+        pool->remote_deallocate(p);
+        if (pool->m_abandoned.load(std::memory_order_seq_cst))
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (pool->m_abandoned.load(std::memory_order_relaxed))
+                pool->drain_remote();
+        }
+    }
+
+    // abandoned pools can't be adopted while the lock is held, so their arenas are safe to walk
+    static MemoryStatistics statistics(const IMemoryPool* local)
+    {
+        MemoryStatistics statistics{};
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        for (IMemoryPool* pool = s_pools; pool; pool = pool->m_next_registered)
+            pool->collect(statistics, pool == local || pool->m_abandoned.load(std::memory_order_relaxed));
+        return statistics;
+    }
+private:
+    static inline std::mutex s_mutex;
+    static inline IMemoryPool* s_abandoned = nullptr;
+    static inline IMemoryPool* s_pools = nullptr;
+};
+
+// trivially destructible, so it stays readable while other thread local objects are destroyed
+static thread_local IMemoryPool* t_local_pool = nullptr;
+
+class LocalMemoryPoolGuard
+{
+public:
+    ~LocalMemoryPoolGuard()
+    {
+        MemoryPoolRegistry::release(t_local_pool);
+        t_local_pool = nullptr;
+    }
+};
+
 // for undefined initialization order
 static IMemoryPool& local_memory_pool()
 {
-    thread_local IMemoryPool t_local_pool;
-    return t_local_pool;
+    if (t_local_pool == nullptr)
+    {
+        t_local_pool = MemoryPoolRegistry::acquire();
+        thread_local LocalMemoryPoolGuard t_guard;
+    }
+    return *t_local_pool;
 }
 
 
@@ -162,12 +860,104 @@ void* allocate(size_t size, size_t alignment, void* data)
 
 void* reallocate(void* p, size_t size, size_t alignment, void* data)
 {
-    return local_memory_pool().reallocate(p, size, alignment, data);
+    IMemoryPool& pool = local_memory_pool();
+    // blocks of other pools can't grow here, caller copies them to a new local block
+    if (p != nullptr && IMemoryPool::owner(p) != &pool)
+        return pool.allocate(size, alignment, data);
+
+    return pool.reallocate(p, size, alignment, data);
 }
 
 void deallocate(void* p)
 {
-    local_memory_pool().deallocate(p);
+    if (p == nullptr)
+        return;
+
+    IMemoryPool* owner = IMemoryPool::owner(p);
+    if (owner == t_local_pool)
+        owner->deallocate(p);
+    else
+        MemoryPoolRegistry::remote_deallocate(owner, p);
+}
+
+
+MemoryStatistics local_memory_statistics()
+{
+    MemoryStatistics statistics{};
+    local_memory_pool().collect(statistics, true);
+    return statistics;
+}
+
+MemoryStatistics global_memory_statistics()
+{
+    return MemoryPoolRegistry::statistics(t_local_pool);
+}
+
+
+class GlobalMemoryResource final : public IMemoryResource
+{
+public:
+    void* allocate(size_t size, size_t alignment, void* data) override
+    {
+        return Amazing::allocate(size, alignment, data);
+    }
+
+    void* reallocate(void* p, size_t size, size_t alignment, void* data) override
+    {
+        return Amazing::reallocate(p, size, alignment, data);
+    }
+
+    void deallocate(void* p) override
+    {
+        Amazing::deallocate(p);
+    }
+};
+
+IMemoryResource* global_memory_resource()
+{
+    static GlobalMemoryResource s_resource;
+    return &s_resource;
+}
+
+
+MemoryPoolResource::MemoryPoolResource(size_t arena_size) : m_pool(new IMemoryPool(arena_size)) {}
+
+MemoryPoolResource::~MemoryPoolResource()
+{
+    delete m_pool;
+    m_pool = nullptr;
+}
+
+void* MemoryPoolResource::allocate(size_t size, size_t alignment, void* data)
+{
+    return m_pool->allocate(size, alignment, data);
+}
+
+void* MemoryPoolResource::reallocate(void* p, size_t size, size_t alignment, void* data)
+{
+    if (p != nullptr && IMemoryPool::owner(p) != m_pool)
+        return m_pool->allocate(size, alignment, data);
+
+    return m_pool->reallocate(p, size, alignment, data);
+}
+
+MemoryStatistics MemoryPoolResource::statistics() const
+{
+    MemoryStatistics statistics{};
+    m_pool->collect(statistics, true);
+    return statistics;
+}
+
+void MemoryPoolResource::deallocate(void* p)
+{
+    if (p == nullptr)
+        return;
+
+    IMemoryPool* owner = IMemoryPool::owner(p);
+    if (owner == m_pool)
+        owner->deallocate(p);
+    else
+        Amazing::deallocate(p);
 }
 
 
@@ -0,0 +1,174 @@
+#include <astd/base/util.h>
+#include <astd/base/logger.h>
+#include <astd/memory/arena.h>
+#include <astd/container/vector.h>
+#include <mutex>
+
+AMAZING_NAMESPACE_BEGIN
+
+static thread_local MonotonicArena* t_current_arena = nullptr;
+
+constexpr static size_t k_block_header_size = 16;
+
+#if defined(_DEBUG) || defined(DEBUG)
+// blocks of live arenas of all threads, so memory released on a wrong thread is caught
+struct BlockRange
+{
+    const uint8_t* begin;
+    const uint8_t* end;
+};
+
+static std::mutex& block_registry_mutex()
+{
+    static std::mutex s_mutex;
+    return s_mutex;
+}
+
+static Vector<BlockRange>& block_registry()
+{
+    static Vector<BlockRange> s_blocks;
+    return s_blocks;
+}
+
+static void register_block(const void* block, size_t size)
+{
+    std::lock_guard<std::mutex> lock(block_registry_mutex());
+    const uint8_t* begin = static_cast<const uint8_t*>(block);
+    block_registry().push_back(BlockRange{begin, begin + size});
+}
+
+static void unregister_block(const void* block)
+{
+    std::lock_guard<std::mutex> lock(block_registry_mutex());
+    Vector<BlockRange>& blocks = block_registry();
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        if (blocks[i].begin == block)
+        {
+            blocks[i] = blocks.back();
+            blocks.pop_back();
+            break;
+        }
+    }
+}
+#endif
+
+
+MonotonicArena::MonotonicArena(size_t block_size) : m_block(nullptr), m_cursor(nullptr), m_last(nullptr), m_block_size(block_size), m_parent(t_current_arena)
+{
+    t_current_arena = this;
+}
+
+MonotonicArena::~MonotonicArena()
+{
+    ASSERT(t_current_arena == this, "astd", "monotonic arena must be destroyed in reverse order of creation!");
+    t_current_arena = m_parent;
+
+    while (m_block)
+    {
+        Block* prev = m_block->prev;
+#if defined(_DEBUG) || defined(DEBUG)
+        unregister_block(m_block);
+#endif
+        Amazing::deallocate(m_block);
+        m_block = prev;
+    }
+    m_cursor = nullptr;
+    m_last = nullptr;
+}
+
+void* MonotonicArena::allocate(size_t size, size_t alignment, void*)
+{
+    if (size == 0)
+        return nullptr;
+
+    if (m_block)
+    {
+        uint8_t* p = reinterpret_cast<uint8_t*>(align_to(reinterpret_cast<uintptr_t>(m_cursor), static_cast<uintptr_t>(alignment)));
+        if (p + size <= reinterpret_cast<uint8_t*>(m_block) + m_block->size)
+        {
+            m_cursor = p + size;
+            m_last = p;
+            return p;
+        }
+    }
+
+    return allocate_block(size, alignment);
+}
+
+void* MonotonicArena::reallocate(void* p, size_t size, size_t alignment, void*)
+{
+    if (p == nullptr)
+        return allocate(size, alignment);
+
+    // memory behind the latest allocation is untouched, and still zeroed
+    if (p == m_last && static_cast<uint8_t*>(p) + size <= reinterpret_cast<uint8_t*>(m_block) + m_block->size)
+    {
+        if (static_cast<uint8_t*>(p) + size > m_cursor)
+            m_cursor = static_cast<uint8_t*>(p) + size;
+        return p;
+    }
+
+    return allocate(size, alignment);
+}
+
+void MonotonicArena::deallocate(void*) {}
+
+bool MonotonicArena::contains(const void* p) const
+{
+    const uint8_t* address = static_cast<const uint8_t*>(p);
+    for (Block* block = m_block; block; block = block->prev)
+    {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(block);
+        if (address >= begin && address < begin + block->size)
+            return true;
+    }
+    return false;
+}
+
+MonotonicArena* MonotonicArena::parent() const
+{
+    return m_parent;
+}
+
+MonotonicArena* MonotonicArena::current()
+{
+    return t_current_arena;
+}
+
+bool MonotonicArena::is_arena_memory(MAYBE_UNUSED const void* p)
+{
+#if defined(_DEBUG) || defined(DEBUG)
+    std::lock_guard<std::mutex> lock(block_registry_mutex());
+    const uint8_t* address = static_cast<const uint8_t*>(p);
+    for (const BlockRange& range : block_registry())
+    {
+        if (address >= range.begin && address < range.end)
+            return true;
+    }
+#endif
+    return false;
+}
+
+void* MonotonicArena::allocate_block(size_t size, size_t alignment)
+{
+    // blocks grow geometrically, so lookups over them stay short
+    size_t block_size = m_block ? m_block->size * 2 : m_block_size;
+    block_size = std::max(block_size, align_to(k_block_header_size + size + alignment, k_cache_alignment));
+
+    Block* block = static_cast<Block*>(Amazing::allocate(block_size));
+    block->prev = m_block;
+    block->size = block_size;
+    m_block = block;
+#if defined(_DEBUG) || defined(DEBUG)
+    register_block(block, block_size);
+#endif
+
+    uint8_t* p = reinterpret_cast<uint8_t*>(align_to(reinterpret_cast<uintptr_t>(block) + k_block_header_size, static_cast<uintptr_t>(alignment)));
+    m_cursor = p + size;
+    m_last = p;
+    return p;
+}
+
+
+AMAZING_NAMESPACE_END
@@ -0,0 +1,78 @@
+#include <astd/memory/pool.h>
+
+AMAZING_NAMESPACE_BEGIN
+
+INTERNAL_NAMESPACE_BEGIN
+
+SlabDepot::SlabDepot(size_t slot_size, size_t alignment) : m_slot_size(slot_size), m_alignment(alignment), m_free(nullptr) {}
+
+void* SlabDepot::take()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    void* p = m_free;
+    m_free = nullptr;
+    return p;
+}
+
+void SlabDepot::give(void* first, void* last)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    *static_cast<void**>(last) = m_free;
+    m_free = first;
+}
+
+
+void SlabCache::flush(SlabDepot& depot)
+{
+    // untouched slots of the latest slab are freed as well
+    while (m_cursor && m_cursor + depot.slot_size() <= m_end)
+    {
+        push(m_cursor);
+        m_cursor += depot.slot_size();
+    }
+    m_cursor = nullptr;
+    m_end = nullptr;
+    m_flushed = true;
+
+    if (m_free == nullptr)
+        return;
+
+    void* last = m_free;
+    while (*static_cast<void**>(last))
+        last = *static_cast<void**>(last);
+    depot.give(m_free, last);
+    m_free = nullptr;
+}
+
+void* SlabCache::refill(SlabDepot& depot)
+{
+    // reuse slots left by exited threads before carving new ones
+    void* p = depot.take();
+    if (p)
+    {
+        m_free = *static_cast<void**>(p);
+        *static_cast<void**>(p) = nullptr;
+    }
+    else
+    {
+        if (m_cursor == nullptr || m_cursor + depot.slot_size() > m_end)
+        {
+            // slab memory is zeroed, and the slab stays alive with the process
+            size_t size = std::max(k_slab_size, depot.slot_size() * 16);
+            m_cursor = static_cast<uint8_t*>(Amazing::allocate(size, std::max(depot.alignment(), k_cache_alignment)));
+            m_end = m_cursor + size;
+        }
+
+        p = m_cursor;
+        m_cursor += depot.slot_size();
+    }
+
+    // the rest would never be flushed again after thread exit
+    if (m_flushed)
+        flush(depot);
+    return p;
+}
+
+INTERNAL_NAMESPACE_END
+
+AMAZING_NAMESPACE_END
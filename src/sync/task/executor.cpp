@@ -4,93 +4,759 @@
 
 #include <astd/sync/task/executor.h>
 #include <astd/sync/task/task.h>
+#include <astd/base/except.h>
+#include <condition_variable>
+#include <cstdio>
 
 AMAZING_NAMESPACE_BEGIN
 
-Worker::Worker(Executor* executor) : m_ref_executor(executor) {}
+// worker running on calling thread, nullptr for threads outside any executor
+static thread_local Worker* t_current_worker = nullptr;
+
+// rounds of stealing before an idle worker parks
+constexpr static uint32_t k_steal_spin_count = 64;
+// ready successors counted for the graph at once
+constexpr static uint32_t k_ready_batch_size = 32;
+
+
+// resumes sleeping coroutines on the executor at their deadlines
+class Timer final : public Thread
+{
+    struct Entry
+    {
+        std::chrono::steady_clock::time_point deadline;
+        std::coroutine_handle<> handle;
+    };
+public:
+    explicit Timer(Executor* executor) : m_ref_executor(executor) {}
+
+    void add(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // sift up, the earliest deadline is at the front
+        m_heap.push_back(Entry{deadline, handle});
+        size_t index = m_heap.size() - 1;
+        while (index > 0 && m_heap[(index - 1) / 2].deadline > m_heap[index].deadline)
+        {
+            swap(m_heap[(index - 1) / 2], m_heap[index]);
+            index = (index - 1) / 2;
+        }
+        if (index == 0)
+            m_condition.notify_one();
+    }
+private:
+    void run(std::stop_token token) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!token.stop_requested())
+        {
+            if (m_heap.empty())
+            {
+                m_condition.wait(lock, token, [this] { return !m_heap.empty(); });
+                continue;
+            }
+
+            std::chrono::steady_clock::time_point deadline = m_heap[0].deadline;
+            if (std::chrono::steady_clock::now() < deadline)
+            {
+                m_condition.wait_until(lock, token, deadline, [&] { return m_heap[0].deadline < deadline; });
+                continue;
+            }
+
+            std::coroutine_handle<> handle = pop();
+            lock.unlock();
+            m_ref_executor->resume(handle);
+            lock.lock();
+        }
+    }
+
+    std::coroutine_handle<> pop()
+    {
+        std::coroutine_handle<> handle = m_heap[0].handle;
+        m_heap[0] = m_heap.back();
+        m_heap.pop_back();
+
+        size_t size = m_heap.size();
+        size_t index = 0;
+        while (true)
+        {
+            size_t earliest = index;
+            size_t left = index * 2 + 1;
+            size_t right = left + 1;
+            if (left < size && m_heap[left].deadline < m_heap[earliest].deadline)
+                earliest = left;
+            if (right < size && m_heap[right].deadline < m_heap[earliest].deadline)
+                earliest = right;
+            if (earliest == index)
+                break;
+
+            swap(m_heap[earliest], m_heap[index]);
+            index = earliest;
+        }
+        return handle;
+    }
+private:
+    Executor* m_ref_executor;
+    Vector<Entry> m_heap;
+    std::mutex m_mutex;
+    std::condition_variable_any m_condition;
+};
+
+
+Worker::Worker(Executor* executor, uint32_t index) : m_ref_executor(executor), m_index(index), m_seed(index * 2654435761u + 1) {}
 
 
 void Worker::run(std::stop_token token)
 {
-    while(true)
+    t_current_worker = this;
+    // stop request wakes the parked worker up
+    std::stop_callback wake(token, [this] { m_ref_executor->notify_all(); });
+    while (!token.stop_requested())
+    {
+        Task* task = nullptr;
+        if (m_queue.pop(task) || (task = steal()) || (task = park(token)))
+            execute(task);
+    }
+    t_current_worker = nullptr;
+}
+
+void Worker::execute(Task* task)
+{
+#ifdef ASTD_EXECUTOR_PROFILING
+    uint64_t begin = m_ref_executor->profile_time();
+#endif
+    if (Internal::is_coroutine(task))
+    {
+        Internal::untag_coroutine(task).resume();
+#ifdef ASTD_EXECUTOR_PROFILING
+        m_profile.events.push_back(WorkerProfile::Event{"coroutine", begin, begin, m_ref_executor->profile_time(), WorkerProfile::Kind::e_coroutine});
+#endif
+        return;
+    }
+
+    // a task in a loop may run again, its predecessors count down from the start again
+    task->m_join_counter.store(task->m_strong_count, std::memory_order_relaxed);
+
+    Subflow subflow(m_ref_executor, task);
+    task->operator()(subflow);
+#ifdef ASTD_EXECUTOR_PROFILING
+    m_profile.events.push_back(WorkerProfile::Event{task->m_name ? task->m_name : "task", task->m_ready_time, begin, m_ref_executor->profile_time(), WorkerProfile::Kind::e_task});
+#endif
+
+    // children left in the subflow are joined, the last of them completes this task
+    if (subflow.m_graph)
+    {
+        subflow.m_graph->prepare();
+        subflow.m_graph->m_completion = GraphCompletion::e_join;
+        subflow.m_graph->m_parent = task;
+        m_ref_executor->launch(*subflow.m_graph);
+        return;
+    }
+
+    complete(task);
+}
+
+void Worker::complete(Task* task)
+{
+    // the graph may be destroyed by its waiter as soon as the last task is counted
+    TaskGraph* graph = task->m_graph;
+    GraphCompletion completion = graph->m_completion;
+    Task* parent = graph->m_parent;
+
+    // pending counts tasks which are ready or running, this worker keeps the ready successor of highest priority
+    // for itself and passes the count of task on to it, others are counted in batches before they are pushed,
+    // in ascending priority, so the owner pops more important ones first
+    Task* next = nullptr;
+    Task* batch[k_ready_batch_size];
+    uint32_t batch_size = 0;
+#ifdef ASTD_EXECUTOR_PROFILING
+    uint64_t ready_time = m_ref_executor->profile_time();
+#endif
+    auto flush = [&]
+    {
+        for (uint32_t i = 1; i < batch_size; ++i)
+        {
+            Task* node = batch[i];
+            uint32_t j = i;
+            for (; j > 0 && batch[j - 1]->m_priority > node->m_priority; --j)
+                batch[j] = batch[j - 1];
+            batch[j] = node;
+        }
+
+        graph->m_pending.fetch_add(batch_size, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < batch_size; ++i)
+        {
+            m_queue.push(batch[i]);
+            m_ref_executor->notify_one();
+        }
+        batch_size = 0;
+    };
+    auto ready = [&](Task* node)
     {
-        if (token.stop_requested())
+#ifdef ASTD_EXECUTOR_PROFILING
+        node->m_ready_time = ready_time;
+#endif
+        if (next == nullptr)
+        {
+            next = node;
             return;
+        }
+
+        if (node->m_priority > next->m_priority)
+            swap(node, next);
+        batch[batch_size++] = node;
+        if (batch_size == k_ready_batch_size)
+            flush();
+    };
 
-        if (Task* task = m_ref_executor->fetch_task())
+    if (task->m_condition)
+    {
+        if (task->m_branch < task->m_succeed_nodes.size())
+            ready(task->m_succeed_nodes[task->m_branch]);
+    }
+    else
+    {
+        for_each(task->m_succeed_nodes, [&](Task* succeed_node)
         {
-            task->operator()();
-            for_each(task->m_succeed_nodes, [this](Task* succeed_node)
-            {
-                uint32_t counter = --succeed_node->m_join_counter;
-                if (counter == 0)
-                    m_ref_executor->insert_task(succeed_node);
-            });
-            --m_ref_executor->m_counter;
+            if (--succeed_node->m_join_counter == 0)
+                ready(succeed_node);
+        });
+    }
+
+    if (batch_size > 0)
+        flush();
+    if (next)
+        m_queue.push(next);
+    else if (graph->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        finish(graph, completion, parent);
+}
+
+void Worker::finish(TaskGraph* graph, GraphCompletion completion, Task* parent)
+{
+    switch (completion)
+    {
+    case GraphCompletion::e_run:
+        m_ref_executor->finish_run();
+        break;
+    case GraphCompletion::e_join:
+        PLACEMENT_DELETE(TaskGraph, graph);
+        complete(parent);
+        break;
+    case GraphCompletion::e_detach:
+    {
+        PLACEMENT_DELETE(TaskGraph, graph);
+        TaskGraph* parent_graph = parent->m_graph;
+        GraphCompletion parent_completion = parent_graph->m_completion;
+        Task* grandparent = parent_graph->m_parent;
+        if (parent_graph->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            finish(parent_graph, parent_completion, grandparent);
+        break;
+    }
+    case GraphCompletion::e_wait:
+        // the parent task destroys the graph after it sees no task pending
+        break;
+    }
+}
+
+Task* Worker::steal()
+{
+    Task* task = nullptr;
+    if (m_ref_executor->m_injection_queue.steal(task))
+    {
+#ifdef ASTD_EXECUTOR_PROFILING
+        m_profile.steals++;
+#endif
+        return task;
+    }
+
+    // start from a random victim, so thieves spread over workers
+    Vector<Worker*>& workers = m_ref_executor->m_worker_pool;
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    size_t count = workers.size();
+    size_t start = m_seed % count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Worker* victim = workers[(start + i) % count];
+        if (victim != this && victim->m_queue.steal(task))
+        {
+#ifdef ASTD_EXECUTOR_PROFILING
+            m_profile.steals++;
+#endif
+            return task;
         }
     }
+
+#ifdef ASTD_EXECUTOR_PROFILING
+    m_profile.failed_steals++;
+#endif
+    return nullptr;
+}
+
+Task* Worker::park(const std::stop_token& token)
+{
+    for (uint32_t i = 0; i < k_steal_spin_count; ++i)
+    {
+        std::this_thread::yield();
+        if (Task* task = steal())
+            return task;
+    }
+
+    Executor& executor = *m_ref_executor;
+    uint32_t epoch = executor.m_epoch.load(std::memory_order_acquire);
+    executor.m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+
+    // a push before the announcement is seen here, a push after it sees the sleeper and changes the epoch
+    Task* task = steal();
+    if (task == nullptr && !token.stop_requested())
+    {
+#ifdef ASTD_EXECUTOR_PROFILING
+        uint64_t begin = executor.profile_time();
+#endif
+        executor.m_epoch.wait(epoch, std::memory_order_acquire);
+#ifdef ASTD_EXECUTOR_PROFILING
+        m_profile.parks++;
+        m_profile.events.push_back(WorkerProfile::Event{"idle", begin, begin, executor.profile_time(), WorkerProfile::Kind::e_idle});
+#endif
+    }
+
+    executor.m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+
+void RunHandle::wait() const
+{
+    if (m_graph)
+        m_executor->wait(*m_graph);
+}
+
+bool RunHandle::done() const
+{
+    return m_graph == nullptr || m_graph->m_pending.load(std::memory_order_acquire) == 0;
+}
+
+bool RunHandle::await_ready() const noexcept
+{
+    return done();
+}
+
+bool RunHandle::await_suspend(std::coroutine_handle<> handle) const
+{
+    // counted before the check, so a run finishing meanwhile either is seen here or sees the waiter
+    Executor& executor = *m_executor;
+    executor.m_waiter_count.fetch_add(1, std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> lock(executor.m_waiter_mutex);
+    if (m_graph->m_pending.load(std::memory_order_seq_cst) == 0)
+    {
+        executor.m_waiter_count.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    executor.m_graph_waiters.push_back(Executor::GraphWaiter{m_graph, handle});
+    return true;
+}
+
+
+void Executor::ScheduleAwaiter::await_suspend(std::coroutine_handle<> handle) const
+{
+    m_executor->resume(handle);
+}
+
+bool Executor::SleepAwaiter::await_ready() const noexcept
+{
+    return m_deadline <= std::chrono::steady_clock::now();
+}
+
+void Executor::SleepAwaiter::await_suspend(std::coroutine_handle<> handle) const
+{
+    m_executor->timer().add(m_deadline, handle);
+}
+
+
+TaskGraph& Subflow::graph()
+{
+    if (m_graph == nullptr)
+        m_graph = PLACEMENT_NEW(TaskGraph, sizeof(TaskGraph));
+    return *m_graph;
+}
+
+void Subflow::join()
+{
+    if (m_graph == nullptr)
+        return;
+
+    m_graph->prepare();
+    m_graph->m_completion = GraphCompletion::e_wait;
+    m_executor->launch(*m_graph);
+    m_executor->wait(*m_graph);
+    PLACEMENT_DELETE(TaskGraph, m_graph);
+    m_graph = nullptr;
+}
+
+void Subflow::detach()
+{
+    if (m_graph == nullptr)
+        return;
+
+    m_graph->prepare();
+    // the parent is still running, so its graph can't finish before the detached graph is counted
+    m_graph->m_completion = GraphCompletion::e_detach;
+    m_graph->m_parent = m_parent;
+    m_parent->m_graph->m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_executor->launch(*m_graph);
+    m_graph = nullptr;
 }
 
 
-Executor::Executor(size_t thread_count) : m_task_index(0)
+Executor::Executor(size_t thread_count, PinningPolicy pinning, ThreadPriority priority) : Executor(thread_count, pinned_cpus(thread_count, pinning), priority) {}
+
+Executor::Executor(size_t thread_count, const Vector<uint32_t>& cpus, ThreadPriority priority)
+    : m_counter(0), m_finished(0), m_epoch(0), m_sleeping(0), m_waiter_count(0), m_timer(nullptr),
+      m_start_time(std::chrono::steady_clock::now()), m_injection_contention(0)
 {
     ASSERT(thread_count > 0 && thread_count <= std::thread::hardware_concurrency(), "astd", "thread count must be in range [1, {}]!", std::thread::hardware_concurrency());
 
+    // missing cpus are rejected before any worker is created
+    for (uint32_t cpu : cpus)
+    {
+        if (cpu >= std::thread::hardware_concurrency())
+            throw AStdException(AStdError::NO_VALID_PARAMETER);
+    }
+
+    // all workers exist before any of them starts stealing
     m_worker_pool.reserve(thread_count);
     for (size_t i = 0; i < thread_count; ++i)
     {
-        m_worker_pool.push_back(PLACEMENT_NEW(Worker, sizeof(Worker), this));
-        m_worker_pool.back()->start();
+        Worker* worker = PLACEMENT_NEW(Worker, sizeof(Worker), this, static_cast<uint32_t>(i));
+        char name[32];
+        std::snprintf(name, sizeof(name), "astd-w%zu", i);
+        worker->set_name(name);
+        worker->set_priority(priority);
+        if (!cpus.empty())
+        {
+            worker->set_affinity({ cpus[i % cpus.size()] });
+        }
+        m_worker_pool.push_back(worker);
     }
+    for (Worker* worker : m_worker_pool)
+        worker->start();
 }
 
 Executor::~Executor()
 {
+    // the timer pushes to the injection queue, stop it first
+    if (m_timer)
+    {
+        m_timer->stop();
+        PLACEMENT_DELETE(Timer, m_timer);
+    }
+
     for (Worker* worker : m_worker_pool)
     {
         if (worker->is_running())
             worker->stop();
-        PLACEMENT_DELETE(Worker, worker);
     }
+    for (Worker* worker : m_worker_pool)
+        PLACEMENT_DELETE(Worker, worker);
     m_worker_pool.clear();
 }
 
-void Executor::run(TaskGraph& graph)
+RunHandle Executor::run(TaskGraph& graph)
+{
+    // a second run would reset the join counters under the first one
+    if (graph.m_pending.load(std::memory_order_acquire) != 0)
+        throw AStdException(AStdError::NO_VALID_PARAMETER);
+    if (graph.m_task_counter == 0)
+        return RunHandle();
+
+    // an invalid graph throws before the run is counted
+    graph.prepare();
+    graph.m_completion = GraphCompletion::e_run;
+    graph.m_parent = nullptr;
+    m_counter.fetch_add(1, std::memory_order_relaxed);
+    launch(graph);
+    return RunHandle(this, &graph);
+}
+
+void Executor::launch(TaskGraph& graph)
 {
-    m_counter = graph.m_task_nodes.size();
-    m_task_pool.reserve(graph.m_task_nodes.size());
-    graph.compile();
+    graph.m_pending.store(graph.m_join_counter, std::memory_order_relaxed);
+
+    // start nodes are sorted by descending priority, the injection queue is taken from its oldest task,
+    // while a worker pops the latest task of its own queue
+    if (is_worker_thread())
+    {
+        for (uint32_t i = graph.m_join_counter; i > 0; --i)
+            insert_task(graph.m_task_nodes[i - 1]);
+    }
+    else
     {
-        std::lock_guard<std::mutex> lock(m_task_mutex);
         for (uint32_t i = 0; i < graph.m_join_counter; ++i)
-            m_task_pool.push_back(graph.m_task_nodes[i]);
+            insert_task(graph.m_task_nodes[i]);
     }
 }
 
+Executor::ScheduleAwaiter Executor::schedule()
+{
+    return ScheduleAwaiter(this);
+}
+
+Executor::SleepAwaiter Executor::sleep_for(std::chrono::steady_clock::duration duration)
+{
+    return SleepAwaiter(this, std::chrono::steady_clock::now() + duration);
+}
+
+Executor::SleepAwaiter Executor::sleep_until(std::chrono::steady_clock::time_point deadline)
+{
+    return SleepAwaiter(this, deadline);
+}
+
 void Executor::wait()
 {
-    while (m_counter.load(std::memory_order_acquire)) {}
-    m_task_pool.clear();
-    m_task_index = 0;
+    // the run of the calling task itself would never finish
+    if (is_worker_thread())
+        throw AStdException(AStdError::NO_VALID_PARAMETER);
+    uint32_t finished = m_finished.load(std::memory_order_acquire);
+    while (m_counter.load(std::memory_order_acquire) != 0)
+    {
+        m_finished.wait(finished, std::memory_order_acquire);
+        finished = m_finished.load(std::memory_order_acquire);
+    }
+}
+
+void Executor::wait(TaskGraph& graph)
+{
+    // a worker keeps executing tasks, some of them are probably from this run
+    if (is_worker_thread())
+    {
+        Worker* worker = t_current_worker;
+        while (graph.m_pending.load(std::memory_order_acquire) != 0)
+        {
+            Task* task = nullptr;
+            if (worker->m_queue.pop(task) || (task = worker->steal()))
+                worker->execute(task);
+            else
+                std::this_thread::yield();
+        }
+        return;
+    }
+
+    // waiters watch the executor instead of the graph, so finishing a run never touches a destroyed graph
+    uint32_t finished = m_finished.load(std::memory_order_acquire);
+    while (graph.m_pending.load(std::memory_order_acquire) != 0)
+    {
+        m_finished.wait(finished, std::memory_order_acquire);
+        finished = m_finished.load(std::memory_order_acquire);
+    }
+}
+
+bool Executor::write_trace(const char* path) const
+{
+    std::FILE* file = std::fopen(path, "w");
+    if (file == nullptr)
+        return false;
+
+    // chrome tracing takes microseconds
+    auto write_name = [file](const char* name)
+    {
+        std::fputc('"', file);
+        for (const char* c = name; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                std::fprintf(file, "\\%c", *c);
+            else if (static_cast<unsigned char>(*c) < 0x20)
+                std::fprintf(file, "\\u%04x", *c);
+            else
+                std::fputc(*c, file);
+        }
+        std::fputc('"', file);
+    };
+
+    constexpr static const char* k_kind_names[] = { "task", "coroutine", "idle" };
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < m_worker_pool.size(); ++i)
+    {
+        const Worker* worker = m_worker_pool[i];
+        const WorkerProfile& profile = worker->m_profile;
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,\"args\":{\"name\":", i);
+        write_name(worker->name().c_str());
+        std::fprintf(file, "}},\n");
+
+        uint64_t task_count = 0;
+        uint64_t idle_time = 0;
+        uint64_t queue_wait_time = 0;
+        uint64_t last = 0;
+        for (const WorkerProfile::Event& event : profile.events)
+        {
+            std::fprintf(file, "{\"name\":");
+            write_name(event.name);
+            std::fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%zu,\"args\":{\"queue_wait_us\":%.3f}},\n",
+                k_kind_names[static_cast<uint8_t>(event.kind)], event.begin / 1000.0, (event.end - event.begin) / 1000.0, i, (event.begin - event.ready) / 1000.0);
+
+            if (event.kind == WorkerProfile::Kind::e_idle)
+                idle_time += event.end - event.begin;
+            else
+            {
+                task_count++;
+                queue_wait_time += event.begin - event.ready;
+            }
+            last = std::max(last, event.end);
+        }
+
+        std::fprintf(file, "{\"name\":\"worker statistics\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%zu,\"args\":"
+            "{\"tasks\":%llu,\"queue_wait_us\":%.3f,\"steals\":%llu,\"failed_steals\":%llu,\"parks\":%llu,\"idle_us\":%.3f}}%s\n",
+            last / 1000.0, i, static_cast<unsigned long long>(task_count), queue_wait_time / 1000.0, static_cast<unsigned long long>(profile.steals),
+            static_cast<unsigned long long>(profile.failed_steals), static_cast<unsigned long long>(profile.parks), idle_time / 1000.0,
+            i + 1 < m_worker_pool.size() ? "," : "");
+    }
+    std::fprintf(file, "],\n\"otherData\":{\"injection_contention\":%llu}}\n",
+        static_cast<unsigned long long>(m_injection_contention.load(std::memory_order_relaxed)));
+
+    return std::fclose(file) == 0;
+}
+
+void Executor::clear_profile()
+{
+    for (Worker* worker : m_worker_pool)
+    {
+        worker->m_profile.events.clear();
+        worker->m_profile.steals = 0;
+        worker->m_profile.failed_steals = 0;
+        worker->m_profile.parks = 0;
+    }
+    m_injection_contention.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Executor::profile_time() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start_time).count();
+}
+
+size_t Executor::thread_count() const
+{
+    return m_worker_pool.size();
+}
+
+bool Executor::is_worker_thread() const
+{
+    return t_current_worker && t_current_worker->m_ref_executor == this;
+}
+
+void Executor::resume(std::coroutine_handle<> handle)
+{
+    insert_task(Internal::tag_coroutine(handle));
 }
 
 void Executor::insert_task(Task* task)
 {
-    std::lock_guard<std::mutex> lock(m_task_mutex);
-    m_task_pool.push_back(task);
+#ifdef ASTD_EXECUTOR_PROFILING
+    if (!Internal::is_coroutine(task))
+        task->m_ready_time = profile_time();
+#endif
+    if (is_worker_thread())
+        t_current_worker->m_queue.push(task);
+    else
+    {
+#ifdef ASTD_EXECUTOR_PROFILING
+        if (!m_injection_mutex.try_lock())
+        {
+            m_injection_contention.fetch_add(1, std::memory_order_relaxed);
+            m_injection_mutex.lock();
+        }
+        std::lock_guard<std::mutex> lock(m_injection_mutex, std::adopt_lock);
+#else
+        std::lock_guard<std::mutex> lock(m_injection_mutex);
+#endif
+        m_injection_queue.push(task);
+    }
+    notify_one();
 }
 
-Task* Executor::fetch_task()
+void Executor::notify_one()
 {
-    std::lock_guard<std::mutex> lock(m_task_mutex);
-    if (m_task_index < m_task_pool.size())
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) > 0)
     {
-        Task* task = m_task_pool[m_task_index];
-        m_task_index++;
-        return task;
+        m_epoch.fetch_add(1, std::memory_order_release);
+        m_epoch.notify_one();
     }
+}
 
-    return nullptr;
+void Executor::notify_all()
+{
+    m_epoch.fetch_add(1, std::memory_order_release);
+    m_epoch.notify_all();
+}
+
+void Executor::finish_run()
+{
+    m_counter.fetch_sub(1, std::memory_order_acq_rel);
+    m_finished.fetch_add(1, std::memory_order_acq_rel);
+    m_finished.notify_all();
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiter_count.load(std::memory_order_relaxed) > 0)
+        resume_waiters();
+}
+
+void Executor::resume_waiters()
+{
+    // graphs in the list are kept alive by their suspended waiters
+    std::lock_guard<std::mutex> lock(m_waiter_mutex);
+    for (size_t i = 0; i < m_graph_waiters.size();)
+    {
+        GraphWaiter& waiter = m_graph_waiters[i];
+        if (waiter.graph->m_pending.load(std::memory_order_acquire) != 0)
+        {
+            ++i;
+            continue;
+        }
+
+        resume(waiter.handle);
+        waiter = m_graph_waiters.back();
+        m_graph_waiters.pop_back();
+        m_waiter_count.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+Timer& Executor::timer()
+{
+    std::lock_guard<std::mutex> lock(m_timer_mutex);
+    if (m_timer == nullptr)
+    {
+        m_timer = PLACEMENT_NEW(Timer, sizeof(Timer), this);
+        m_timer->set_name("astd-timer");
+        m_timer->start();
+    }
+    return *m_timer;
+}
+
+
+Vector<uint32_t> Executor::pinned_cpus(size_t thread_count, PinningPolicy pinning)
+{
+    Vector<uint32_t> cpus;
+    if (pinning == PinningPolicy::e_none)
+        return cpus;
+
+    // by logical cpu index
+    size_t cpu_count = std::max(std::thread::hardware_concurrency(), 1u);
+    cpus.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        size_t cpu = pinning == PinningPolicy::e_compact ? i : i * cpu_count / thread_count;
+        cpus.push_back(static_cast<uint32_t>(cpu % cpu_count));
+    }
+    return cpus;
+}
+
+
+Executor& default_executor()
+{
+    // workers are joined at exit, after the last parallel call of main
+    static Executor s_executor(std::max(std::thread::hardware_concurrency(), 1u));
+    return s_executor;
 }
 
-AMAZING_NAMESPACE_END
\ No newline at end of file
+AMAZING_NAMESPACE_END
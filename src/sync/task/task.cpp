@@ -3,18 +3,45 @@
 //
 
 #include <astd/sync/task/task.h>
+#include <astd/base/except.h>
 
 AMAZING_NAMESPACE_BEGIN
 
-TaskGraph::TaskGraph(uint32_t task_count) : m_task_counter(0), m_join_counter(0)
+void Task::link(Task* task)
+{
+    m_precede_nodes.push_back(task);
+    task->m_succeed_nodes.push_back(this);
+    if (!task->m_condition)
+        m_strong_count++;
+}
+
+void Task::invalidate()
+{
+    if (m_graph)
+        m_graph->m_compiled = false;
+}
+
+
+TaskGraph::TaskGraph(uint32_t task_count)
+    : m_task_block(nullptr), m_free_task(nullptr), m_task_counter(0), m_join_counter(0), m_compiled(false), m_pending(0),
+      m_completion(GraphCompletion::e_run), m_parent(nullptr)
 {
     m_task_nodes.reserve(task_count);
+    if (task_count > 0)
+        add_task_block(std::max(task_count, k_min_task_block_capacity));
 }
 
 TaskGraph::~TaskGraph()
 {
     for (uint32_t i = 0; i < m_task_counter; ++i)
-        PLACEMENT_DELETE(Task, m_task_nodes[i]);
+        m_task_nodes[i]->~Task();
+
+    while (m_task_block)
+    {
+        uint8_t* block = reinterpret_cast<uint8_t*>(m_task_block);
+        m_task_block = m_task_block->prev;
+        Allocator<uint8_t>::deallocate(block);
+    }
 }
 
 void TaskGraph::erase(Task* task)
@@ -41,6 +68,8 @@ void TaskGraph::erase(Task* task)
             {
                 node->m_precede_nodes[i] = node->m_precede_nodes.back();
                 node->m_precede_nodes.pop_back();
+                if (!task->m_condition)
+                    node->m_strong_count--;
                 break;
             }
         }
@@ -51,39 +80,123 @@ void TaskGraph::erase(Task* task)
         if (m_task_nodes[i] == task)
         {
             m_task_nodes[i] = m_task_nodes[m_task_counter - 1];
+            m_task_nodes.pop_back();
             m_task_counter--;
-            PLACEMENT_DELETE(Task, task);
+            m_compiled = false;
+            task->~Task();
+            *reinterpret_cast<Task**>(task) = m_free_task;
+            m_free_task = task;
             break;
         }
     }
 }
 
+Task* TaskGraph::allocate_task()
+{
+    if (Task* task = m_free_task)
+    {
+        m_free_task = *reinterpret_cast<Task**>(task);
+        return task;
+    }
+
+    if (m_task_block == nullptr)
+        add_task_block(k_min_task_block_capacity);
+    else if (m_task_block->size == m_task_block->capacity)
+        add_task_block(std::min(m_task_block->capacity * 2, k_max_task_block_capacity));
+
+    Task* slots = reinterpret_cast<Task*>(reinterpret_cast<uint8_t*>(m_task_block) + align_to(sizeof(TaskBlock), alignof(Task)));
+    return slots + m_task_block->size++;
+}
+
+void TaskGraph::add_task_block(uint32_t capacity)
+{
+    size_t size = align_to(sizeof(TaskBlock), alignof(Task)) + sizeof(Task) * capacity;
+    TaskBlock* block = reinterpret_cast<TaskBlock*>(Allocator<uint8_t>::allocate(size, std::max(alignof(TaskBlock), alignof(Task))));
+    block->prev = m_task_block;
+    block->capacity = capacity;
+    block->size = 0;
+    m_task_block = block;
+}
+
+void TaskGraph::prepare()
+{
+    if (!m_compiled)
+        compile();
+
+    for (uint32_t i = 0; i < m_task_counter; ++i)
+    {
+        Task* task = m_task_nodes[i];
+        task->m_join_counter.store(task->m_strong_count, std::memory_order_relaxed);
+    }
+}
+
 void TaskGraph::compile()
 {
-    uint32_t node_count = m_task_counter;
-    uint32_t start_node_count = 0;
+    // topological order over edges which count for join, edges from condition tasks may form loops
+    Vector<Task*> order;
+    order.reserve(m_task_counter);
+    for (uint32_t i = 0; i < m_task_counter; ++i)
+    {
+        Task* task = m_task_nodes[i];
+        task->m_join_counter.store(task->m_strong_count, std::memory_order_relaxed);
+        if (task->m_strong_count == 0)
+            order.push_back(task);
+    }
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        if (order[i]->m_condition)
+            continue;
+
+        for (Task* node : order[i]->m_succeed_nodes)
+        {
+            if (node->m_join_counter.fetch_sub(1, std::memory_order_relaxed) == 1)
+                order.push_back(node);
+        }
+    }
+    // a cycle without condition task would never be ready
+    if (order.size() != m_task_counter)
+        throw AStdException(AStdError::NO_VALID_PARAMETER);
 
-    Vector<uint32_t> start_nodes(node_count);
-    for (uint32_t i = 0; i < node_count; ++i)
+    // priority is the cost of the longest path from a task to the end
+    for (size_t i = order.size(); i > 0; --i)
     {
-        uint32_t dependency_count = m_task_nodes[i]->m_precede_nodes.size();
-        if (dependency_count == 0)
+        Task* task = order[i - 1];
+        uint64_t longest = 0;
+        if (!task->m_condition)
         {
-            start_nodes[start_node_count] = i;
+            for (Task* node : task->m_succeed_nodes)
+                longest = std::max(longest, node->m_priority);
+        }
+        task->m_priority = longest + task->m_cost;
+    }
+
+    uint32_t start_node_count = 0;
+    for (uint32_t i = 0; i < m_task_counter; ++i)
+    {
+        if (m_task_nodes[i]->m_precede_nodes.empty())
+        {
+            swap(m_task_nodes[i], m_task_nodes[start_node_count]);
             start_node_count++;
         }
-        else
-            m_task_nodes[i]->m_join_counter = dependency_count;
     }
-    ASSERT(start_node_count > 0, "astd", "task graph must have at least one start node!");
+    if (start_node_count == 0)
+        throw AStdException(AStdError::NO_VALID_PARAMETER);
 
-    m_join_counter = 0;
-    for (uint32_t i = 0; i < start_node_count; ++i)
+    // start nodes often share one priority, then there is nothing to sort
+    auto higher = [](Task* lhs, Task* rhs)
+    {
+        return lhs->m_priority > rhs->m_priority;
+    };
+    for (uint32_t i = 1; i < start_node_count; ++i)
     {
-        swap(m_task_nodes[start_nodes[i]], m_task_nodes[m_join_counter]);
-        m_join_counter++;
+        if (higher(m_task_nodes[i], m_task_nodes[i - 1]))
+        {
+            sort(m_task_nodes.data(), m_task_nodes.data() + start_node_count, higher);
+            break;
+        }
     }
+    m_join_counter = start_node_count;
+    m_compiled = true;
 }
 
-
 AMAZING_NAMESPACE_END
\ No newline at end of file
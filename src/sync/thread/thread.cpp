@@ -3,10 +3,97 @@
 //
 
 #include <astd/sync/thread/thread.h>
+#include <astd/base/logger.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 AMAZING_NAMESPACE_BEGIN
 
-Thread::Thread() : m_running(false) {}
+// longest name linux accepts, without the terminator
+constexpr static size_t k_max_thread_name_length = 15;
+
+static bool set_current_thread_name(const String& name)
+{
+#ifdef _WIN32
+    wchar_t wide_name[256];
+    if (MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, wide_name, 256) == 0)
+        return false;
+    return SUCCEEDED(SetThreadDescription(GetCurrentThread(), wide_name));
+#elif defined(__linux__)
+    char short_name[k_max_thread_name_length + 1] = {};
+    std::memcpy(short_name, name.c_str(), std::min(name.size(), k_max_thread_name_length));
+    return pthread_setname_np(pthread_self(), short_name) == 0;
+#else
+    return false;
+#endif
+}
+
+static bool set_current_thread_affinity(const Vector<uint32_t>& cpus)
+{
+#ifdef _WIN32
+    // a thread runs in one processor group, logical cpus are numbered over all groups in order
+    GROUP_AFFINITY affinity = {};
+    bool grouped = false;
+    for (uint32_t cpu : cpus)
+    {
+        WORD group = 0;
+        DWORD index = cpu;
+        while (group < GetActiveProcessorGroupCount() && index >= GetActiveProcessorCount(group))
+            index -= GetActiveProcessorCount(group++);
+        if (group == GetActiveProcessorGroupCount() || (grouped && group != affinity.Group))
+            return false;
+
+        affinity.Group = group;
+        affinity.Mask |= static_cast<KAFFINITY>(1) << index;
+        grouped = true;
+    }
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif defined(__linux__)
+    // sized by the highest cpu, so machines with more than CPU_SETSIZE cpus are covered
+    uint32_t cpu_count = 0;
+    for (uint32_t cpu : cpus)
+        cpu_count = std::max(cpu_count, cpu + 1);
+    cpu_set_t* set = CPU_ALLOC(cpu_count);
+    if (set == nullptr)
+        return false;
+
+    size_t set_size = CPU_ALLOC_SIZE(cpu_count);
+    CPU_ZERO_S(set_size, set);
+    for (uint32_t cpu : cpus)
+        CPU_SET_S(cpu, set_size, set);
+    bool result = pthread_setaffinity_np(pthread_self(), set_size, set) == 0;
+    CPU_FREE(set);
+    return result;
+#else
+    return false;
+#endif
+}
+
+static bool set_current_thread_priority(ThreadPriority priority)
+{
+#ifdef _WIN32
+    constexpr static int k_priorities[] = { THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST };
+    return SetThreadPriority(GetCurrentThread(), k_priorities[static_cast<uint8_t>(priority)]) != 0;
+#elif defined(__linux__)
+    // nice value of a thread is per thread on linux
+    constexpr static int k_nice_values[] = { 19, 10, 0, -5, -10 };
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), k_nice_values[static_cast<uint8_t>(priority)]) == 0;
+#else
+    return false;
+#endif
+}
+
+
+Thread::Thread() : m_running(false), m_priority(ThreadPriority::e_normal) {}
 
 Thread::~Thread()
 {
@@ -19,6 +106,7 @@ void Thread::start()
     {
         m_thread = std::jthread([&](std::stop_token token)
         {
+            this->apply_attributes();
             this->run(std::move(token));
         });
         m_running = true;
@@ -35,6 +123,24 @@ void Thread::stop()
     }
 }
 
+void Thread::set_name(const char* name)
+{
+    ASSERT(!m_running, "astd", "thread attributes must be set before it starts!");
+    m_name = name;
+}
+
+void Thread::set_affinity(const Vector<uint32_t>& cpus)
+{
+    ASSERT(!m_running, "astd", "thread attributes must be set before it starts!");
+    m_affinity = cpus;
+}
+
+void Thread::set_priority(ThreadPriority priority)
+{
+    ASSERT(!m_running, "astd", "thread attributes must be set before it starts!");
+    m_priority = priority;
+}
+
 bool Thread::is_running() const
 {
     return m_running;
@@ -46,4 +152,36 @@ uint32_t Thread::id() const
     return *reinterpret_cast<uint32_t*>(&thread_id);
 }
 
-AMAZING_NAMESPACE_END
\ No newline at end of file
+const String& Thread::name() const
+{
+    return m_name;
+}
+
+const Vector<uint32_t>& Thread::affinity() const
+{
+    return m_affinity;
+}
+
+ThreadPriority Thread::priority() const
+{
+    return m_priority;
+}
+
+void Thread::apply_attributes() const
+{
+    MAYBE_UNUSED bool named = m_name.empty() || set_current_thread_name(m_name);
+    MAYBE_UNUSED bool pinned = m_affinity.empty() || set_current_thread_affinity(m_affinity);
+    MAYBE_UNUSED bool prioritized = m_priority == ThreadPriority::e_normal || set_current_thread_priority(m_priority);
+
+    // failures are only reported in debug builds, the thread runs with what it got
+#if defined(_DEBUG) || defined(DEBUG)
+    if (!named)
+        LOG_WARNING("astd", "failed to name thread {}!", m_name.c_str());
+    if (!pinned)
+        LOG_WARNING("astd", "failed to set affinity of thread {} over {} cpus!", m_name.c_str(), m_affinity.size());
+    if (!prioritized)
+        LOG_WARNING("astd", "failed to set priority {} of thread!", static_cast<uint32_t>(m_priority));
+#endif
+}
+
+AMAZING_NAMESPACE_END
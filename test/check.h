@@ -0,0 +1,22 @@
+//
+// Created by AmazingBuff on 2025/10/17.
+//
+
+#pragma once
+
+#include <cstdio>
+
+// a failed check is reported and the test goes on, main returns the result of all checks
+inline int g_check_failures = 0;
+
+#define CHECK(expr)                                                                         \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(expr))                                                                        \
+        {                                                                                   \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);            \
+            g_check_failures++;                                                             \
+        }                                                                                   \
+    } while (0)
+
+#define CHECK_RESULT() (g_check_failures == 0 ? 0 : 1)
@@ -0,0 +1,279 @@
+//
+// Created by AmazingBuff on 2025/10/17.
+//
+
+#include <astd/container/dynamic_vector.h>
+#include <astd/container/map.h>
+#include <astd/container/set.h>
+#include <astd/container/list.h>
+#include <astd/memory/arena.h>
+#include <astd/memory/pool.h>
+#include <astd/base/except.h>
+#include <thread>
+#include <optional>
+#include <cstring>
+#include "check.h"
+
+using namespace Amazing;
+
+static constexpr size_t k_test_arena_size = 1024 * 1024;
+
+// counters are only maintained when built with ASTD_MEMORY_STATISTICS
+static bool statistics_enabled()
+{
+    void* p = Amazing::allocate(16);
+    Amazing::deallocate(p);
+    return local_memory_statistics().allocate_count > 0;
+}
+
+static bool is_zeroed(const void* p, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(p);
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (bytes[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+// a freed block is found again by the next request of its size class, and comes back zeroed
+static void bin_reuse()
+{
+    void* a = Amazing::allocate(256);
+    void* b = Amazing::allocate(256);
+    void* c = Amazing::allocate(256);
+    std::memset(b, 0xff, 256);
+    Amazing::deallocate(b);
+
+    void* d = Amazing::allocate(256);
+    CHECK(d == b);
+    CHECK(is_zeroed(d, 256));
+
+    Amazing::deallocate(a);
+    Amazing::deallocate(c);
+    Amazing::deallocate(d);
+}
+
+// a block freed on another thread returns to its owner, which reuses it after its next allocation,
+// byte counts only move with memory statistics
+static void remote_free()
+{
+    void* warm = Amazing::allocate(1024);
+    Amazing::deallocate(warm);
+
+    size_t baseline = local_memory_statistics().bytes_in_use;
+    void* p = Amazing::allocate(1024);
+    std::memset(p, 0xff, 1024);
+    std::thread([p] { Amazing::deallocate(p); }).join();
+
+    void* q = Amazing::allocate(1024);
+    CHECK(q == p);
+    CHECK(is_zeroed(q, 1024));
+    Amazing::deallocate(q);
+    CHECK(local_memory_statistics().bytes_in_use == baseline);
+}
+
+// a block freed into the pool of an exited thread is released right away, not when a new thread adopts the pool
+static void abandoned_remote_free()
+{
+    void* p = nullptr;
+    std::thread([&p] { p = Amazing::allocate(1024); }).join();
+
+    size_t in_use = global_memory_statistics().bytes_in_use;
+    Amazing::deallocate(p);
+    CHECK(global_memory_statistics().bytes_in_use < in_use);
+}
+
+// a full arena is followed by another one instead of failing
+static void arena_chaining()
+{
+    MemoryPoolResource pool(k_test_arena_size);
+    Vector<void*> blocks;
+    for (size_t i = 0; i < 32; ++i)
+    {
+        void* p = pool.allocate(64 * 1024, k_cache_alignment, nullptr);
+        CHECK(p != nullptr && is_zeroed(p, 64 * 1024));
+        std::memset(p, static_cast<int>(i), 64 * 1024);
+        blocks.push_back(p);
+    }
+    CHECK(pool.statistics().bytes_reserved > 2 * k_test_arena_size);
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+        CHECK(static_cast<uint8_t*>(blocks[i])[64 * 1024 - 1] == static_cast<uint8_t>(i));
+    for (void* p : blocks)
+        pool.deallocate(p);
+}
+
+// huge requests get a mapping of their own, which is released with them
+static void dedicated_mapping()
+{
+    MemoryPoolResource pool(k_test_arena_size);
+    size_t reserved = pool.statistics().bytes_reserved;
+
+    void* p = pool.allocate(4 * k_test_arena_size, k_cache_alignment, nullptr);
+    CHECK(p != nullptr);
+    std::memset(p, 0xff, 4 * k_test_arena_size);
+    CHECK(pool.statistics().bytes_reserved >= reserved + 4 * k_test_arena_size);
+
+    pool.deallocate(p);
+    CHECK(pool.statistics().bytes_reserved == reserved);
+}
+
+// node containers which opt in to PoolAllocator draw their nodes from per-thread slabs
+static void pool_allocator_containers()
+{
+    constexpr int k_count = 10000;
+
+    Map<int, int, Less<int>, PoolAllocator> map;
+    for (int i = 0; i < k_count; ++i)
+        map.emplace(i, i * 2);
+    for (int i = 0; i < k_count; i += 2)
+        map.erase(i);
+    // freed nodes are reused by the next insertions
+    for (int i = 0; i < k_count; i += 2)
+        map.emplace(i, i * 2);
+    CHECK(map.size() == k_count);
+    bool values = true;
+    for (int i = 0; i < k_count; ++i)
+        values = values && map[i] == i * 2;
+    CHECK(values);
+
+    Set<int, Less<int>, PoolAllocator> set;
+    for (int i = k_count; i > 0; --i)
+        set.emplace(i % 100);
+    CHECK(set.size() == 100);
+
+    List<int, PoolAllocator> list;
+    for (int i = 0; i < k_count; ++i)
+        list.push_back(i);
+    for (int i = 0; i < k_count / 2; ++i)
+        list.pop_front();
+    CHECK(list.size() == k_count / 2 && list.front() == k_count / 2);
+
+    // slots hold single objects, arrays are rejected
+    bool thrown = false;
+    try
+    {
+        Vector<int, PoolAllocator> vector;
+        vector.reserve(16);
+    }
+    catch (const AStdException&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+struct ExitNode
+{
+    uint64_t value[5];
+};
+
+// the list is created after the slab cache of its thread, so it is destroyed after the cache is flushed
+struct ExitList
+{
+    std::optional<List<ExitNode, PoolAllocator>> list;
+};
+
+// slots freed by thread local destructors after the thread exit flush still reach other threads
+static void pool_allocator_thread_exit()
+{
+    constexpr size_t k_count = 16;
+    const ExitNode* freed[k_count] = {};
+    std::thread([&]
+    {
+        static thread_local ExitList t_exit_list;
+        t_exit_list.list.emplace();
+        for (size_t i = 0; i < k_count; ++i)
+            t_exit_list.list->push_back(ExitNode{});
+        size_t i = 0;
+        for (ExitNode& node : *t_exit_list.list)
+            freed[i++] = &node;
+    }).join();
+
+    List<ExitNode, PoolAllocator> list;
+    for (size_t i = 0; i < k_count; ++i)
+        list.push_back(ExitNode{});
+    bool reused = true;
+    for (ExitNode& node : list)
+        reused = reused && std::find(freed, freed + k_count, &node) != freed + k_count;
+    CHECK(reused);
+}
+
+// a buffer allocated outside an arena stays in the memory pool when it grows inside the arena
+static void monotonic_reallocate()
+{
+    Vector<int, MonotonicAllocator> items;
+    items.push_back(0);
+    {
+        MonotonicArena arena;
+        for (int i = 1; i < 1000; ++i)
+            items.push_back(i);
+        CHECK(!arena.contains(items.data()));
+    }
+    for (int i = 1000; i < 2000; ++i)
+        items.push_back(i);
+
+    bool values = true;
+    for (int i = 0; i < 2000; ++i)
+        values = values && items[i] == i;
+    CHECK(values);
+}
+
+// every call is counted, and bytes in use go back once the blocks are freed
+static void statistics_counters()
+{
+    MemoryStatistics before = local_memory_statistics();
+    void* blocks[3];
+    for (void*& p : blocks)
+        p = Amazing::allocate(100);
+
+    MemoryStatistics during = local_memory_statistics();
+    CHECK(during.allocate_count == before.allocate_count + 3);
+    CHECK(during.bytes_in_use >= before.bytes_in_use + 300);
+    CHECK(during.peak_bytes_in_use >= during.bytes_in_use);
+
+    for (void* p : blocks)
+        Amazing::deallocate(p);
+    MemoryStatistics after = local_memory_statistics();
+    CHECK(after.deallocate_count == before.deallocate_count + 3);
+    CHECK(after.bytes_in_use == before.bytes_in_use);
+}
+
+// buckets dropped by a shrinking reserve are released
+static void dynamic_vector_shrink()
+{
+    size_t baseline = local_memory_statistics().bytes_in_use;
+    {
+        DynamicVector<int> v;
+        v.reserve(20 * DynamicVector<int>::Block_Size);
+        CHECK(v.capacity() == 20 * DynamicVector<int>::Block_Size);
+        v.reserve(2 * DynamicVector<int>::Block_Size);
+        CHECK(v.capacity() == 2 * DynamicVector<int>::Block_Size);
+    }
+
+    CHECK(local_memory_statistics().bytes_in_use == baseline);
+}
+
+int main()
+{
+    bin_reuse();
+    remote_free();
+    arena_chaining();
+    dedicated_mapping();
+    pool_allocator_containers();
+    pool_allocator_thread_exit();
+    monotonic_reallocate();
+
+    if (statistics_enabled())
+    {
+        statistics_counters();
+        abandoned_remote_free();
+        dynamic_vector_shrink();
+    }
+    else
+        std::printf("memory statistics are disabled, skip counting checks\n");
+
+    return CHECK_RESULT();
+}
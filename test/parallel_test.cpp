@@ -0,0 +1,300 @@
+//
+// Created by AmazingBuff on 2025/10/17.
+//
+
+#include <astd/sync/parallel.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include "check.h"
+
+using namespace Amazing;
+
+static size_t test_thread_count()
+{
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+}
+
+template <typename Tp>
+static bool equal(Vector<Tp> const& lhs, Vector<Tp> const& rhs)
+{
+    if (lhs.size() != rhs.size())
+        return false;
+    for (size_t i = 0; i < lhs.size(); ++i)
+    {
+        if (lhs[i] != rhs[i])
+            return false;
+    }
+    return true;
+}
+
+// both strategies visit every item once, the parallel one on the default executor
+static void for_each_strategies()
+{
+    Vector<int> items;
+    for (int i = 0; i < 5000; ++i)
+        items.push_back(i);
+
+    for (ParallelStrategy strategy : { ParallelStrategy::e_sequential, ParallelStrategy::e_parallel })
+    {
+        std::atomic<int64_t> sum(0);
+        for_each(strategy, items, [&](int item) { sum.fetch_add(item, std::memory_order_relaxed); });
+        CHECK(sum.load() == 5000 * 4999 / 2);
+    }
+}
+
+// every index is visited exactly once whatever the partitioner and grain size
+static void partitioners(Executor& executor)
+{
+    constexpr size_t k_count = 100000;
+    for (Partitioner partitioner : { Partitioner::e_static, Partitioner::e_dynamic, Partitioner::e_guided })
+    {
+        for (size_t grain_size : { k_auto_grain_size, static_cast<size_t>(1), static_cast<size_t>(1000) })
+        {
+            std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[k_count]());
+            parallel_for(executor, static_cast<size_t>(0), k_count, [&](size_t i)
+            {
+                visits[i].fetch_add(1, std::memory_order_relaxed);
+            }, grain_size, partitioner);
+
+            bool once = true;
+            for (size_t i = 0; i < k_count; ++i)
+                once = once && visits[i].load(std::memory_order_relaxed) == 1;
+            CHECK(once);
+        }
+    }
+
+    // for_each on an executor is split into pieces like parallel_for
+    Vector<int> items;
+    for (int i = 0; i < 5000; ++i)
+        items.push_back(i);
+    std::atomic<int64_t> sum(0);
+    for_each(executor, items, [&](int item) { sum.fetch_add(item, std::memory_order_relaxed); });
+    CHECK(sum.load() == 5000 * 4999 / 2);
+}
+
+// threads which call record, at most k_max_threads of them
+struct ThreadSet
+{
+    static constexpr size_t k_max_threads = 16;
+
+    void record()
+    {
+        std::thread::id id = std::this_thread::get_id();
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (ids[i] == id)
+                return;
+        }
+        if (count < k_max_threads)
+            ids[count++] = id;
+    }
+
+    std::mutex mutex;
+    std::thread::id ids[k_max_threads];
+    size_t count = 0;
+};
+
+// a loop inside a task is split like any other, and other workers take part in it
+static void nested_parallel_for(Executor& executor)
+{
+    constexpr size_t k_count = 100000;
+    std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[k_count]());
+    ThreadSet threads;
+
+    TaskGraph graph;
+    graph.emplace([&]
+    {
+        parallel_for(executor, static_cast<size_t>(0), k_count, [&](size_t i)
+        {
+            visits[i].fetch_add(1, std::memory_order_relaxed);
+            if (i % 64 == 0)
+            {
+                threads.record();
+                // keep pieces long enough for idle workers to steal some
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+            }
+        }, 1024);
+    });
+    executor.run(graph).wait();
+
+    bool once = true;
+    for (size_t i = 0; i < k_count; ++i)
+        once = once && visits[i].load(std::memory_order_relaxed) == 1;
+    CHECK(once);
+    if (executor.thread_count() > 1)
+        CHECK(threads.count > 1);
+}
+
+static void reductions(Executor& executor)
+{
+    Vector<int64_t> items;
+    for (int64_t i = 0; i < 100000; ++i)
+        items.push_back((i * 7919) % 100003);
+
+    int64_t sum = 0;
+    for (int64_t item : items)
+        sum += item;
+    CHECK(reduce(executor, items, static_cast<int64_t>(0), [](int64_t lhs, int64_t rhs) { return lhs + rhs; }) == sum);
+    CHECK(transform_reduce(executor, items, static_cast<int64_t>(0), [](int64_t lhs, int64_t rhs) { return lhs + rhs; },
+                           [](int64_t item) { return item * 2; }) == sum * 2);
+    CHECK(count_if(executor, items, [](int64_t item) { return item % 2 == 0; }) ==
+          count_if(items, [](int64_t item) { return item % 2 == 0; }));
+    CHECK(*min_element(executor, items) == 0);
+    CHECK(*max_element(executor, items) == 100002);
+}
+
+// reductions and scans inside a task are split too, and other workers take part in them
+static void nested_reductions(Executor& executor)
+{
+    Vector<int64_t> items;
+    for (int64_t i = 0; i < 50000; ++i)
+        items.push_back(i);
+    ThreadSet threads;
+
+    int64_t sum = 0;
+    bool scanned = true;
+    TaskGraph graph;
+    graph.emplace([&]
+    {
+        sum = reduce(executor, items, static_cast<int64_t>(0), [&](int64_t lhs, int64_t rhs)
+        {
+            if (rhs % 64 == 0)
+            {
+                threads.record();
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+            }
+            return lhs + rhs;
+        });
+
+        Vector<int64_t> output(items.size());
+        inclusive_scan(executor, items, output, [](int64_t lhs, int64_t rhs) { return lhs + rhs; });
+        for (size_t i = 0; i < output.size(); ++i)
+            scanned = scanned && output[i] == static_cast<int64_t>(i * (i + 1) / 2);
+    });
+    executor.run(graph).wait();
+
+    CHECK(sum == 50000ll * 49999 / 2);
+    CHECK(scanned);
+    if (executor.thread_count() > 1)
+        CHECK(threads.count > 1);
+}
+
+// op is only associative, so pieces must be combined in order
+static void scans(Executor& executor)
+{
+    Vector<uint32_t> input;
+    for (uint32_t i = 0; i < 50000; ++i)
+        input.push_back(i % 13);
+
+    auto plus = [](uint32_t lhs, uint32_t rhs) { return lhs + rhs; };
+    Vector<uint32_t> expected(input.size());
+    Vector<uint32_t> output(input.size());
+
+    exclusive_scan(input, expected, 7u, plus);
+    exclusive_scan(executor, input, output, 7u, plus);
+    CHECK(equal(output, expected));
+
+    inclusive_scan(input, expected, plus);
+    inclusive_scan(executor, input, output, plus);
+    CHECK(equal(output, expected));
+
+    // output may be the input itself
+    inclusive_scan(executor, input, input, plus);
+    CHECK(equal(input, expected));
+}
+
+// runs of equal keys must not make the sequential leaves quadratic
+static void sort_duplicate_keys(Executor& executor)
+{
+    constexpr uint32_t k_count = 200000;
+    for (uint32_t key_count : { 1u, 3u, 1000u })
+    {
+        Vector<uint32_t> items;
+        Vector<uint32_t> histogram(key_count);
+        for (uint32_t i = 0; i < k_count; ++i)
+        {
+            items.push_back(i * 2654435761u % key_count);
+            histogram[items.back()]++;
+        }
+
+        sort(executor, items);
+
+        bool sorted = true;
+        for (uint32_t i = 1; i < k_count; ++i)
+            sorted = sorted && items[i - 1] <= items[i];
+        CHECK(sorted);
+        // nothing is lost or duplicated by the merges
+        for (uint32_t item : items)
+            histogram[item]--;
+        CHECK(count_if(histogram, [](uint32_t count) { return count != 0; }) == 0);
+    }
+
+    Vector<uint32_t> items;
+    for (uint32_t i = 0; i < k_count; ++i)
+        items.push_back(i % 2);
+    sort(ParallelStrategy::e_sequential, items, [](uint32_t lhs, uint32_t rhs) { return lhs > rhs; });
+    CHECK(items.front() == 1 && items.back() == 0 && items[k_count / 2 - 1] == 1 && items[k_count / 2] == 0);
+}
+
+// only movable and without a default constructor, live counts the instances constructed minus those destroyed
+struct MoveOnlyKey
+{
+    static inline std::atomic<int64_t> live = 0;
+
+    explicit MoveOnlyKey(uint32_t value) : value(value) { live.fetch_add(1, std::memory_order_relaxed); }
+    MoveOnlyKey(MoveOnlyKey&& other) noexcept : value(other.value) { live.fetch_add(1, std::memory_order_relaxed); }
+    MoveOnlyKey& operator=(MoveOnlyKey&& other) noexcept = default;
+    ~MoveOnlyKey() { live.fetch_sub(1, std::memory_order_relaxed); }
+
+    bool operator<(MoveOnlyKey const& other) const { return value < other.value; }
+
+    uint32_t value;
+};
+
+// the merge buffer is built by moving elements, so they need no default constructor, also inside a task
+static void sort_move_only(Executor& executor)
+{
+    constexpr uint32_t k_count = 100000;
+    bool sorted = true;
+    bool balanced = true;
+    auto sort_keys = [&]
+    {
+        Vector<MoveOnlyKey> items;
+        for (uint32_t i = 0; i < k_count; ++i)
+            items.emplace_back(i * 35761u % k_count);
+
+        int64_t live = MoveOnlyKey::live.load();
+        sort(executor, items);
+        // every element moved into the buffer is destroyed with it
+        balanced = balanced && MoveOnlyKey::live.load() == live;
+
+        for (uint32_t i = 0; i < k_count; ++i)
+            sorted = sorted && items[i].value == i;
+    };
+
+    sort_keys();
+    TaskGraph graph;
+    graph.emplace(sort_keys);
+    executor.run(graph).wait();
+
+    CHECK(sorted);
+    CHECK(balanced);
+}
+
+int main()
+{
+    for_each_strategies();
+
+    Executor executor(test_thread_count());
+    partitioners(executor);
+    nested_parallel_for(executor);
+    reductions(executor);
+    nested_reductions(executor);
+    scans(executor);
+    sort_duplicate_keys(executor);
+    sort_move_only(executor);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,581 @@
+//
+// Created by AmazingBuff on 2025/10/17.
+//
+
+#include <astd/sync/task/coroutine.h>
+#include <astd/memory/arena.h>
+#include <astd/base/except.h>
+#include <algorithm>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "check.h"
+
+using namespace Amazing;
+
+static size_t test_thread_count()
+{
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+}
+
+// b->precede(a) lets a run before b
+
+// successors made ready by one worker are stolen by the others
+static void work_stealing(Executor& executor)
+{
+    constexpr uint32_t k_count = 10000;
+    std::atomic<uint32_t> count(0);
+    uint32_t result = 0;
+    auto increment = [&] { count++; };
+    auto collect = [&] { result = count.load(); };
+
+    TaskGraph graph;
+    Task* root = graph.emplace(increment);
+    Task* last = graph.emplace(collect);
+    for (uint32_t i = 0; i < k_count; ++i)
+    {
+        Task* task = graph.emplace(increment);
+        task->precede(root);
+        last->precede(task);
+    }
+
+    executor.run(graph);
+    executor.wait();
+    CHECK(result == k_count + 1);
+}
+
+// parked workers wake up for a new run, and wait blocks until it is finished
+static void parking_and_wait(Executor& executor)
+{
+    std::atomic<uint32_t> count(0);
+    auto increment = [&] { count++; };
+    for (uint32_t round = 1; round <= 2; ++round)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        TaskGraph graph;
+        for (uint32_t i = 0; i < 100; ++i)
+            graph.emplace(increment);
+        executor.run(graph);
+        executor.wait();
+        CHECK(count.load() == round * 100);
+    }
+}
+
+// a graph runs again with its join counters reset, and recompiles after it changes
+static void graph_rerun(Executor& executor)
+{
+    Vector<uint32_t> order;
+    std::mutex mutex;
+    auto record = [&](uint32_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(id);
+    };
+    auto record_0 = [&] { record(0); };
+    auto record_1 = [&] { record(1); };
+    auto record_2 = [&] { record(2); };
+    auto record_3 = [&] { record(3); };
+
+    TaskGraph graph;
+    Task* a = graph.emplace(record_0);
+    Task* b = graph.emplace(record_1);
+    Task* c = graph.emplace(record_2);
+    b->precede(a);
+    c->precede(b);
+
+    for (uint32_t run = 0; run < 3; ++run)
+    {
+        executor.run(graph);
+        executor.wait();
+    }
+    CHECK(order.size() == 9);
+    bool ordered = true;
+    for (uint32_t i = 0; i < order.size(); ++i)
+        ordered = ordered && order[i] == i % 3;
+    CHECK(ordered);
+
+    order.clear();
+    Task* d = graph.emplace(record_3);
+    d->precede(c);
+    executor.run(graph);
+    executor.wait();
+    CHECK(order.size() == 4 && order.back() == 3);
+
+    order.clear();
+    graph.erase(d);
+    executor.run(graph);
+    executor.wait();
+    CHECK(order.size() == 3 && order.back() == 2);
+}
+
+// runs started from several threads at once finish independently, wait covers all of them
+static void concurrent_runs(Executor& executor)
+{
+    constexpr uint32_t k_graph_count = 4;
+    std::atomic<uint32_t> count(0);
+    auto increment = [&] { count++; };
+    TaskGraph graphs[k_graph_count];
+    for (TaskGraph& graph : graphs)
+    {
+        for (uint32_t i = 0; i < 100; ++i)
+            graph.emplace(increment);
+    }
+
+    Vector<RunHandle> handles;
+    std::mutex mutex;
+    std::thread threads[k_graph_count];
+    for (uint32_t i = 0; i < k_graph_count; ++i)
+    {
+        threads[i] = std::thread([&, i]
+        {
+            RunHandle handle = executor.run(graphs[i]);
+            std::lock_guard<std::mutex> lock(mutex);
+            handles.push_back(handle);
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    executor.wait();
+    CHECK(count.load() == k_graph_count * 100);
+    bool done = true;
+    for (RunHandle const& handle : handles)
+        done = done && handle.done();
+    CHECK(done);
+
+    // a handle waits for its own run only
+    RunHandle handle = executor.run(graphs[0]);
+    handle.wait();
+    CHECK(handle.done() && count.load() == (k_graph_count + 1) * 100);
+
+    // a graph can't run again before its previous run is finished
+    std::atomic<bool> blocked(true);
+    TaskGraph blocking;
+    blocking.emplace([&]
+    {
+        while (blocked.load())
+            std::this_thread::yield();
+    });
+    RunHandle first = executor.run(blocking);
+    bool rejected = false;
+    try
+    {
+        executor.run(blocking);
+    }
+    catch (const AStdException&)
+    {
+        rejected = true;
+    }
+    blocked.store(false);
+    first.wait();
+    CHECK(rejected && first.done());
+    executor.wait();
+}
+
+// children are copied into the subflow, so temporaries are fine there
+static void subflow(Executor& executor)
+{
+    constexpr uint32_t k_child_count = 100;
+
+    // implicit join, successors of the parent wait for its children
+    {
+        std::atomic<uint32_t> count(0);
+        uint32_t seen = 0;
+        auto spawn = [&](Subflow& subflow)
+        {
+            for (uint32_t i = 0; i < k_child_count; ++i)
+                subflow.emplace([&] { count++; });
+        };
+        auto collect = [&] { seen = count.load(); };
+
+        TaskGraph graph;
+        Task* parent = graph.emplace(spawn);
+        Task* next = graph.emplace(collect);
+        next->precede(parent);
+
+        executor.run(graph).wait();
+        CHECK(seen == k_child_count);
+    }
+
+    // join inside the body, then more children which are joined at the end
+    {
+        std::atomic<uint32_t> count(0);
+        uint32_t joined = 0;
+        auto spawn = [&](Subflow& subflow)
+        {
+            for (uint32_t i = 0; i < k_child_count; ++i)
+                subflow.emplace([&] { count++; });
+            subflow.join();
+            joined = count.load();
+            subflow.emplace([&] { count++; });
+        };
+
+        TaskGraph graph;
+        graph.emplace(spawn);
+        executor.run(graph).wait();
+        CHECK(joined == k_child_count);
+        CHECK(count.load() == k_child_count + 1);
+    }
+
+    // detached children are still counted by the run
+    {
+        std::atomic<uint32_t> count(0);
+        auto spawn = [&](Subflow& subflow)
+        {
+            for (uint32_t i = 0; i < k_child_count; ++i)
+                subflow.emplace([&] { count++; });
+            subflow.detach();
+        };
+
+        TaskGraph graph;
+        graph.emplace(spawn);
+        executor.run(graph).wait();
+        CHECK(count.load() == k_child_count);
+    }
+}
+
+// children and their edges outlive a scratch arena of the parent body
+static void subflow_in_arena(Executor& executor)
+{
+    std::atomic<uint32_t> count(0);
+    TaskGraph graph;
+    graph.emplace([&](Subflow& subflow)
+    {
+        MonotonicArena arena;
+        Task* last = subflow.emplace([&] { count++; });
+        for (uint32_t i = 0; i < 40; ++i)
+            last->precede(subflow.emplace([&] { count++; }));
+
+        Vector<uint32_t, MonotonicAllocator> scratch;
+        scratch.resize(256);
+    });
+
+    executor.run(graph).wait();
+    CHECK(count.load() == 41);
+}
+
+// a graph built outside an arena keeps its node list out of an arena it is extended in
+static void graph_grown_in_arena(Executor& executor)
+{
+    std::atomic<uint32_t> count(0);
+    TaskGraph graph;
+    graph.emplace([&] { count++; });
+    {
+        MonotonicArena arena;
+        for (uint32_t i = 0; i < 4; ++i)
+            graph.emplace([&] { count++; });
+    }
+    for (uint32_t i = 0; i < 20; ++i)
+        graph.emplace([&] { count++; });
+
+    executor.run(graph).wait();
+    CHECK(count.load() == 25);
+}
+
+// nodes and edges added inside an arena scope, more than fit in a block or inline, outlive that arena
+static void precede_in_arena(Executor& executor)
+{
+    std::atomic<uint32_t> count(0);
+    uint32_t seen = 0;
+    TaskGraph graph;
+    Task* last = graph.emplace([&] { seen = count.load(); });
+    {
+        MonotonicArena arena;
+        for (uint32_t i = 0; i < 100; ++i)
+            last->precede(graph.emplace([&] { count++; }));
+    }
+
+    executor.run(graph).wait();
+    CHECK(seen == 100);
+}
+
+// the condition task returns the index of the successor to run, its edges may go back
+static void condition_loop(Executor& executor)
+{
+    uint32_t iteration = 0;
+    uint32_t result = 0;
+    auto reset = [&] { iteration = 0; };
+    auto step = [&] { iteration++; };
+    auto more = [&]() -> int { return iteration < 10 ? 0 : 1; };
+    auto collect = [&] { result = iteration; };
+
+    TaskGraph graph;
+    Task* init = graph.emplace(reset);
+    Task* body = graph.emplace(step);
+    Task* condition = graph.emplace(more);
+    Task* done = graph.emplace(collect);
+    body->precede(init);
+    condition->precede(body);
+    body->precede(condition);
+    done->precede(condition);
+
+    for (uint32_t run = 0; run < 2; ++run)
+    {
+        result = 0;
+        executor.run(graph).wait();
+        CHECK(result == 10);
+    }
+}
+
+// a graph which could never finish is rejected before it is counted as a run
+static void invalid_graphs(Executor& executor)
+{
+    auto rejected = [&](TaskGraph& graph)
+    {
+        try
+        {
+            executor.run(graph);
+        }
+        catch (const AStdException&)
+        {
+            return true;
+        }
+        return false;
+    };
+
+    // cycle without condition task
+    TaskGraph cycle;
+    Task* a = cycle.emplace([] {});
+    Task* b = cycle.emplace([] {});
+    b->precede(a);
+    a->precede(b);
+    CHECK(rejected(cycle));
+
+    // every task has a predecessor, even if only through a condition task
+    TaskGraph loop;
+    Task* condition = loop.emplace([]() -> int { return 0; });
+    condition->precede(condition);
+    CHECK(rejected(loop));
+
+    // wait does not count the rejected runs
+    executor.wait();
+}
+
+// start nodes on the longest weighted path are taken first
+static void priority()
+{
+    Executor executor(1);
+    Vector<uint32_t> order;
+    auto record_0 = [&] { order.push_back(0); };
+    auto record_1 = [&] { order.push_back(1); };
+    auto record_2 = [&] { order.push_back(2); };
+
+    TaskGraph graph;
+    Task* short_path = graph.emplace(record_0);
+    Task* long_path = graph.emplace(record_1);
+    Task* tail = graph.emplace(record_2);
+    tail->precede(long_path);
+    tail->set_cost(5);
+
+    executor.run(graph).wait();
+    CHECK(long_path->priority() == 6 && short_path->priority() == 1);
+    CHECK(order.size() == 3 && order[0] == 1);
+
+    // a changed cost is picked up by the next run
+    order.clear();
+    short_path->set_cost(10);
+    executor.run(graph).wait();
+    CHECK(short_path->priority() == 10);
+    CHECK(order.size() == 3 && order[0] == 0);
+}
+
+static Coroutine<uint32_t> add_on_worker(Executor& executor, uint32_t lhs, uint32_t rhs)
+{
+    co_await executor.schedule();
+    co_return lhs + rhs;
+}
+
+static Coroutine<void> fail_on_worker(Executor& executor)
+{
+    co_await executor.schedule();
+    throw std::runtime_error("coroutine failed");
+}
+
+static Coroutine<void> drive_coroutines(Executor& executor, TaskGraph& graph, std::atomic<uint32_t>& result)
+{
+    uint32_t sum = co_await add_on_worker(executor, 1, 2);
+
+    auto start = std::chrono::steady_clock::now();
+    co_await executor.sleep_for(std::chrono::milliseconds(10));
+    if (std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10))
+        sum += 10;
+
+    co_await executor.run(graph);
+
+    try
+    {
+        co_await fail_on_worker(executor);
+    }
+    catch (const std::runtime_error&)
+    {
+        sum += 100;
+    }
+    result = sum;
+}
+
+// coroutines suspend on the executor, timers and runs, values and exceptions come back to the awaiting one
+static void coroutines(Executor& executor)
+{
+    std::atomic<uint32_t> count(0);
+    auto increment = [&] { count++; };
+    TaskGraph graph;
+    for (uint32_t i = 0; i < 10; ++i)
+        graph.emplace(increment);
+
+    std::atomic<uint32_t> result(0);
+    executor.spawn(drive_coroutines(executor, graph, result));
+    executor.wait();
+    CHECK(result.load() == 113);
+    CHECK(count.load() == 10);
+
+    // a task waiting for all runs would wait for its own one, it has to co_await instead
+    bool rejected = false;
+    TaskGraph waiting;
+    waiting.emplace([&]
+    {
+        try
+        {
+            executor.wait();
+        }
+        catch (const AStdException&)
+        {
+            rejected = true;
+        }
+    });
+    executor.run(waiting).wait();
+    CHECK(rejected);
+}
+
+// pinned workers run graphs like free ones, named and on the cpus they are pinned to
+static void pinned_workers()
+{
+    for (PinningPolicy pinning : { PinningPolicy::e_compact, PinningPolicy::e_scatter })
+    {
+        Executor executor(test_thread_count(), pinning);
+        std::atomic<uint32_t> count(0);
+        auto increment = [&] { count++; };
+        TaskGraph graph;
+        for (uint32_t i = 0; i < 100; ++i)
+            graph.emplace(increment);
+        executor.run(graph).wait();
+        CHECK(count.load() == 100);
+    }
+
+    Executor executor(1, Vector<uint32_t>{ 0 }, ThreadPriority::e_low);
+    int cpu = -1;
+    char name[16] = {};
+    auto inspect = [&]
+    {
+#if defined(__linux__)
+        cpu = sched_getcpu();
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+#else
+        cpu = 0;
+        std::strcpy(name, "astd-w");
+#endif
+    };
+    TaskGraph graph;
+    graph.emplace(inspect);
+    executor.run(graph).wait();
+    CHECK(cpu == 0);
+    CHECK(std::strncmp(name, "astd-w", 6) == 0);
+
+    // a cpu which does not exist is rejected before any worker starts
+    bool thrown = false;
+    try
+    {
+        Executor invalid(1, Vector<uint32_t>{ std::thread::hardware_concurrency() + 64 });
+    }
+    catch (const AStdException&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+// the trace always names the workers, task spans are only recorded when built with ASTD_EXECUTOR_PROFILING
+static void write_trace(Executor& executor)
+{
+    constexpr const char* k_path = "task_test_trace.json";
+    std::atomic<uint32_t> count(0);
+    auto increment = [&] { count++; };
+    TaskGraph graph;
+    for (uint32_t i = 0; i < 10; ++i)
+        graph.emplace(increment)->set_name("traced");
+
+    executor.clear_profile();
+    executor.run(graph).wait();
+    CHECK(executor.write_trace(k_path));
+
+    String trace;
+    if (std::FILE* file = std::fopen(k_path, "r"))
+    {
+        char buffer[4096];
+        size_t size;
+        while ((size = std::fread(buffer, 1, sizeof(buffer) - 1, file)) > 0)
+        {
+            buffer[size] = '\0';
+            trace += buffer;
+        }
+        std::fclose(file);
+    }
+    std::remove(k_path);
+
+    CHECK(std::strstr(trace.c_str(), "\"traceEvents\"") != nullptr);
+    CHECK(std::strstr(trace.c_str(), "astd-w") != nullptr);
+    if (std::strstr(trace.c_str(), "\"ph\":\"X\"") != nullptr)
+        CHECK(std::strstr(trace.c_str(), "\"traced\"") != nullptr);
+}
+
+static void emplace_temporaries(TaskGraph& graph, std::atomic<uint32_t>& sum, uint32_t& shared)
+{
+    for (uint32_t i = 0; i < 20; ++i)
+        graph.emplace([&sum](uint32_t value) { sum += value; }, i);
+    graph.emplace([](uint32_t& value) { value = 42; }, std::ref(shared));
+}
+
+// tasks keep copies of their callable and arguments, and slots of erased tasks are reused
+static void task_storage(Executor& executor)
+{
+    std::atomic<uint32_t> sum(0);
+    uint32_t shared = 0;
+    TaskGraph graph;
+    emplace_temporaries(graph, sum, shared);
+    executor.run(graph).wait();
+    CHECK(sum.load() == 190);
+    CHECK(shared == 42);
+
+    Task* erased = graph.emplace([] {});
+    graph.erase(erased);
+    Task* reused = graph.emplace([&sum] { sum += 10; });
+    CHECK(reused == erased);
+    executor.run(graph).wait();
+    CHECK(sum.load() == 2 * 190 + 10);
+}
+
+int main()
+{
+    Executor executor(test_thread_count());
+    work_stealing(executor);
+    parking_and_wait(executor);
+    graph_rerun(executor);
+    concurrent_runs(executor);
+    subflow(executor);
+    subflow_in_arena(executor);
+    graph_grown_in_arena(executor);
+    precede_in_arena(executor);
+    condition_loop(executor);
+    invalid_graphs(executor);
+    priority();
+    coroutines(executor);
+    pinned_workers();
+    write_trace(executor);
+    task_storage(executor);
+
+    return CHECK_RESULT();
+}